@@ -0,0 +1,34 @@
+//===- Kernel.h -----------------------------------------------------------===//
+//
+//                              The SkyPat team
+//
+//  This file is distributed under the New BSD License.
+//  See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#include <skypat/skypat.h>
+#include <stdint.h>
+#include <chrono>
+
+// Scrambles a seed by rounds of xorshift. The whole computation is visible
+// to the compiler, which deletes it if the result is not used.
+inline uint64_t scramble(uint64_t pSeed, int pRounds)
+{
+  for (int i = 0; i < pRounds; ++i) {
+    pSeed ^= pSeed << 13;
+    pSeed ^= pSeed >> 7;
+    pSeed ^= pSeed << 17;
+  }
+  return pSeed;
+}
+
+// Returns the nanoseconds that a function takes.
+template<typename Func>
+int64_t elapsed(Func pFunc)
+{
+  std::chrono::steady_clock::time_point start =
+                                           std::chrono::steady_clock::now();
+  pFunc();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,76 @@
+//===- main.cpp -----------------------------------------------------------===//
+//
+//                              The SkyPat Team
+//
+// This file is distributed under the New BSD License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This sample shows how to keep the compiler from deleting the work of a
+// PERFORM body, and checks that it does. It is built with -O3.
+//
+//===----------------------------------------------------------------------===//
+#include <vector>
+#include "Kernel.h"
+
+static const int kRounds = 1000;
+static const int kLoops = 10000;
+
+// The result of a body is often thrown away, and an optimizing compiler is
+// free to delete the work that produces it. skypat::Sink keeps the result,
+// and skypat::DoNotOptimize on the input keeps the compiler from computing
+// the result at compile time.
+SKYPAT_F(OptimizeCase, sink_test)
+{
+  uint64_t seed = 1;
+
+  // The compiler may delete this body entirely.
+  PERFORM(skypat::TASK_CLOCK) {
+    scramble(seed, kRounds);
+  }
+
+  // This one is measured for real.
+  PERFORM(skypat::TASK_CLOCK) {
+    skypat::DoNotOptimize(seed);
+    skypat::Sink(scramble(seed, kRounds));
+  }
+
+  // The kept kernel must take much longer than an empty loop. It would not
+  // if the computation were deleted.
+  int64_t kept = elapsed([&] {
+    for (int i = 0; i < kLoops; ++i) {
+      skypat::DoNotOptimize(seed);
+      skypat::Sink(scramble(seed, kRounds));
+    }
+  });
+  int64_t empty = elapsed([&] {
+    for (int i = 0; i < kLoops; ++i)
+      skypat::DoNotOptimize(seed);
+  });
+  ASSERT_TRUE(kept > 10 * empty);
+  ASSERT_TRUE(kept >= kLoops * kRounds / 10);
+}
+
+// ClobberMemory forces the stores to escaped memory to be done, even if
+// nothing reads them afterward.
+SKYPAT_F(OptimizeCase, clobber_test)
+{
+  std::vector<int> buffer;
+  buffer.reserve(kRounds);
+
+  PERFORM(skypat::TASK_CLOCK) {
+    buffer.clear();
+    skypat::DoNotOptimize(buffer.data());
+    for (int i = 0; i < kRounds; ++i)
+      buffer.push_back(i);
+    skypat::ClobberMemory();
+  }
+  ASSERT_EQ(buffer.size(), kRounds);
+}
+
+int main(int argc, char* argv[])
+{
+  skypat::Test::Initialize(argc, argv);
+  skypat::Test::RunAll();
+}
@@ -18,8 +18,11 @@
 
 // Step 1. Include necessary header files such that the stuff your test logic
 // needs is declared.
+#include <numeric>
+#include <vector>
 #include <unistd.h>
 #include "skypat/skypat.h"
+#include "skypat/StaticPerform.h"
 #include "my_case.h"
 
 // Step 2. Use the macro to define your performance test.
@@ -48,20 +51,32 @@ SKYPAT_F(MyCase, fibonacci_test)
 {
   // PERFORM macro is used to measure the performance of code within a test. The
   // code to be benchmark within a code block following this macro.
-  PERFORM(skypat::CONTEXT_SWITCHES) {
-    fibonacci(10);
-  }
-  PERFORM(skypat::CPU_CLOCK) {
-    fibonacci(10);
+  //
+  // All events given to a PERFORM are counted together in the same run, so
+  // their numbers can be compared with each other directly.
+  //
+  // skypat::Sink consumes the result, such that an optimizing compiler can't
+  // delete the work of the body.
+  PERFORM(skypat::CPU_CYCLES, skypat::INSTRUCTIONS, skypat::CONTEXT_SWITCHES,
+          skypat::CPU_CLOCK, skypat::TASK_CLOCK) {
+    skypat::Sink(fibonacci(10));
   }
-  PERFORM(skypat::TASK_CLOCK) {
-    fibonacci(10);
+  // A region can run untimed iterations before it is measured, such that
+  // cold caches and page faults are excluded from the result.
+  PERFORM(skypat::TASK_CLOCK, skypat::WarmupIterations(100)) {
+    skypat::Sink(fibonacci(10));
   }
-  PERFORM(skypat::CPU_CYCLES) {
-    fibonacci(10);
+  // A region can also time every iteration alone, and report the tail of the
+  // latencies rather than the average.
+  PERFORM(skypat::LatencyHistogram()) {
+    skypat::Sink(fibonacci(10));
   }
-  PERFORM(skypat::INSTRUCTIONS) {
-    fibonacci(10);
+  // Model-specific events are given by strings: a raw event such as r00c0,
+  // an event of a PMU such as cpu/event=0xc0,umask=0x00/, or the name of an
+  // event under /sys/bus/event_source/devices/<pmu>/events. The -e option
+  // adds such events to every PERFORM.
+  PERFORM(skypat::TASK_CLOCK, skypat::Event("r00c0")) {
+    skypat::Sink(fibonacci(10));
   }
 }
 
@@ -81,6 +96,108 @@ SKYPAT_F(MyCase, factorial_test)
   }
 }
 
+// The setup of an iteration, such as refilling the input, can be left out
+// of the measurement by pausing the region. ScopedPause pauses it until the
+// end of its scope; the cost of the pause itself is subtracted as well. A
+// pause may cost a system call, so the work left unpaused must take well
+// longer than that.
+SKYPAT_F(MyCase, pause_test)
+{
+  std::vector<int> data;
+  PERFORM(skypat::TASK_CLOCK) {
+    {
+      skypat::ScopedPause pause;
+      data.assign(64 << 10, 1);
+    }
+    skypat::Sink(std::accumulate(data.begin(), data.end(), 0));
+  }
+}
+
+// The cache events count the accesses and the misses of one cache, such as
+// the L1 data cache or the data TLB. Touching one int of every page misses
+// both far more often than a sequential walk does.
+SKYPAT_F(MyCase, stride_test)
+{
+  std::vector<int> data(4 << 20, 1);
+  PERFORM(skypat::L1D_READ_ACCESS, skypat::L1D_READ_MISS,
+          skypat::DTLB_READ_MISS) {
+    int sum = 0;
+    for (size_t i = 0; i < data.size(); i += 4096 / sizeof(int))
+      sum += data[i];
+    skypat::Sink(sum);
+  }
+}
+
+// A sampled region also reports where its time goes, as a list of its
+// hottest functions. The -s option samples every PERFORM.
+SKYPAT_F(MyCase, profile_test)
+{
+  PERFORM(skypat::TASK_CLOCK, skypat::SamplingProfile(50)) {
+    skypat::Sink(fibonacci(20) + factorial(20));
+  }
+}
+
+// The events of PERFORM_STATIC are fixed at compile time, so the region
+// keeps its timer and counters inline instead of allocating and opening
+// them on every run.
+SKYPAT_F(MyCase, static_test)
+{
+  PERFORM_STATIC(skypat::TASK_CLOCK, skypat::CONTEXT_SWITCHES) {
+    skypat::Sink(fibonacci(10));
+  }
+}
+
+// A PERFORM in the body of another is a phase of it. It runs once for every
+// iteration of the outer region, and every region reports the time of its
+// body and the time without its phases, such as a request pipeline broken
+// down into parsing, handling and responding.
+//
+// PERFORM_NAMED names a region, so that its results are keyed by
+// case.test.name, such as MyCase.pipeline_test.request/parse, instead of
+// by a line that moves whenever the source changes.
+SKYPAT_F(MyCase, pipeline_test)
+{
+  PERFORM_NAMED("request", skypat::TASK_CLOCK) {
+    int request = 0;
+    PERFORM_NAMED("parse", skypat::TASK_CLOCK) {
+      request = fibonacci(12);
+    }
+    PERFORM_NAMED("handle", skypat::TASK_CLOCK) {
+      request = factorial(request % 12);
+    }
+    PERFORM_NAMED("respond") {
+      skypat::Sink(fibonacci(8) + request);
+    }
+  }
+}
+
+// SKYPAT_LAP splits a single region into phases. Every lap reads the
+// counters once, which is cheaper than a nested PERFORM, and the rest of
+// the iteration after the last lap is reported as "(rest)".
+SKYPAT_F(MyCase, lap_test)
+{
+  PERFORM(skypat::TASK_CLOCK, skypat::CONTEXT_SWITCHES) {
+    int request = fibonacci(12);
+    SKYPAT_LAP("parse");
+    request = factorial(request % 12);
+    SKYPAT_LAP("handle");
+    skypat::Sink(fibonacci(8) + request);
+  }
+}
+
+// A parameterized test runs once for every argument of a set, and the
+// time of its PERFORMs is fitted to the common complexities, such as O(n).
+// Bytes and Items declare the work of an iteration, which is reported as a
+// throughput.
+SKYPAT_P(ScaleCase, sum_test, skypat::Range(64, 64 << 10))
+{
+  std::vector<int> data(arg(0), 1);
+  PERFORM(skypat::TASK_CLOCK, skypat::Bytes(data.size() * sizeof(int)),
+          skypat::Items(data.size())) {
+    skypat::Sink(std::accumulate(data.begin(), data.end(), 0));
+  }
+}
+
 // Step 3. Call RunAll() in main().
 //
 // This runs all the tests you've defined, prints the result and
@@ -58,6 +58,29 @@ SKYPAT_F(ThreadTest, monitor_test)
   ASSERT_TRUE(MonitorThread::get_ten);
 }
 
+// PERFORM_THREADS runs its body on one, two, ... up to four threads, which
+// start together. Every thread is measured alone, and the sum of their
+// iterations per second shows how well the lock scales.
+SKYPAT_F(ThreadTest, contention_test)
+{
+  PERFORM_THREADS(4, skypat::TASK_CLOCK, skypat::CONTEXT_SWITCHES) {
+    Counter::self()->increase();
+  };
+
+  ASSERT_TRUE(Counter::self()->value() > 20);
+}
+
+// PERFORM_SCALING sweeps up to the number of online CPUs. The speedup and
+// efficiency of every number of threads are fitted to the Universal
+// Scalability Law, whose contention (sigma) and coherency (kappa) tell where
+// the lock stops scaling.
+SKYPAT_F(ThreadTest, scaling_test)
+{
+  PERFORM_SCALING(skypat::TASK_CLOCK) {
+    Counter::self()->increase();
+  };
+}
+
 // Step 3. Call RunAll() in main().
 //
 // This runs all the tests you've defined, prints the result and
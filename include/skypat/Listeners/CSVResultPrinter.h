@@ -31,6 +31,8 @@ public:
 
   ~CSVResultPrinter();
 
+  /// open - append the rows to a file. An existing file with other columns
+  /// is moved aside to <file>.1, <file>.2, ... first.
   bool open(const std::string& pFileName);
 
   void OnTestEnd(const testing::TestInfo& pTestInfo);
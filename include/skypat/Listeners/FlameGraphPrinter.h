@@ -0,0 +1,56 @@
+//===- FlameGraphPrinter.h ------------------------------------------------===//
+//
+//                     The skypat Team
+//
+// This file is distributed under the New BSD License. 
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#ifndef SKYPAT_LISTENERS_FLAME_GRAPH_PRINTER_H
+#define SKYPAT_LISTENERS_FLAME_GRAPH_PRINTER_H
+#include <skypat/skypat.h>
+#include <skypat/Support/Path.h>
+#include <string>
+#include <ostream>
+
+namespace skypat {
+namespace testing {
+
+class UnitTest;
+class TestCase;
+class TestInfo;
+
+} // namespace of UnitTest
+
+//===----------------------------------------------------------------------===//
+// FlameGraphPrinter
+//===----------------------------------------------------------------------===//
+/** \class FlameGraphPrinter
+ *  \brief FlameGraphPrinter writes the samples of every sampled PERFORM.
+ *
+ *  Each region gets two files in the output directory, named by the key of
+ *  the region, see TestInfo::getKey(): `<name>.folded` holds the folded
+ *  stacks, one "a;b;c count" per line, and `<name>.svg` is a flame graph of
+ *  them.
+ */
+class FlameGraphPrinter : public skypat::testing::Listener
+{
+public:
+  explicit FlameGraphPrinter(const std::string& pDirectory);
+
+  void OnTestEnd(const testing::TestInfo& pTestInfo);
+
+  /// PrintFolded - print the stacks of a profile in the folded format.
+  static void PrintFolded(std::ostream& pOS, const testing::Profile& pProfile);
+
+  /// PrintSVG - draw the stacks of a profile as a flame graph.
+  static void PrintSVG(std::ostream& pOS, const testing::Profile& pProfile,
+                       const std::string& pTitle);
+
+private:
+  Path m_Directory;
+};
+
+} // namespace skypat
+
+#endif
@@ -31,6 +31,7 @@ public:
   void OnTestCaseStart(const testing::TestCase& pTestCase);
   void OnTestStart(const testing::TestInfo& pTestInfo);
   void OnTestEnd(const testing::TestInfo& pTestInfo);
+  void OnTestCaseEnd(const testing::TestCase& pTestCase);
   void OnTestProgramEnd(const testing::UnitTest& pUnitTest);
 };
 
@@ -0,0 +1,72 @@
+//===- StaticPerform.h ----------------------------------------------------===//
+//
+//                     The SkyPat Team
+//
+// This file is distributed under the New BSD License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#ifndef SKYPAT_STATIC_PERFORM_H
+#define SKYPAT_STATIC_PERFORM_H
+#include <skypat/skypat.h>
+#include <skypat/Support/Timer.h>
+#include <skypat/Support/Perf.h>
+
+namespace skypat {
+namespace testing {
+
+/** \class StaticPerfIterator
+ *  \brief StaticPerfIterator is a PerfIterator whose events are known at
+ *  compile time.
+ *
+ *  The timer and the counters live inside the iterator, on the stack of the
+ *  PERFORM_STATIC loop, and the perf group of the events is looked up once
+ *  per thread, so the counters are neither allocated nor opened on every
+ *  region. The rest is the out-of-line PerfIterator of PERFORM: the result
+ *  of the region and its samples are still allocated, and the counters are
+ *  started and stopped out of line. The events given by -e are not
+ *  counted, since the set is fixed.
+ *
+ *  Nested in a PERFORM that counts events missing from the set, the region
+ *  allocates counters for them, too, as a nested PERFORM does. Otherwise
+ *  the exclusive costs of the parent could not leave them out.
+ */
+template<enum PerfEvent First, enum PerfEvent... Rest>
+class StaticPerfIterator
+{
+public:
+  /// @param pFileName the source file name.
+  /// @param pLoC the line of code.
+  StaticPerfIterator(const char* pFileName, int pLoC)
+    : m_Timer(), m_Perf(),
+      m_Iterator(pFileName, pLoC, PerfSpec(), m_Timer,
+                 static_cast<internal::Perf&>(m_Perf)) {
+  }
+
+  StaticPerfIterator& next() { m_Iterator.next(); return *this; }
+
+  bool hasNext() { return m_Iterator.hasNext(); }
+
+private:
+  internal::Timer m_Timer;
+  internal::StaticPerf<First, Rest...> m_Perf;
+  PerfIterator m_Iterator;
+};
+
+} // namespace of testing
+
+// PERFORM_STATIC is PERFORM with a set of events known at compile time, e.g.,
+//
+//   PERFORM_STATIC(skypat::CPU_CYCLES, skypat::INSTRUCTIONS) {
+//     Kernel();
+//   }
+//
+#define PERFORM_STATIC(...) \
+  for (skypat::testing::StaticPerfIterator<__VA_ARGS__> __loop(__FILE__, \
+                                                               __LINE__); \
+                                                __loop.hasNext(); \
+                                                __loop.next() )
+
+} // namespace of skypat
+
+#endif
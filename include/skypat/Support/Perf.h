@@ -9,35 +9,197 @@
 #ifndef SKYPAT_SUPPORT_PERF_H
 #define SKYPAT_SUPPORT_PERF_H
 #include <skypat/skypat.h>
+#include <string>
+#include <vector>
+#include <array>
 
 namespace skypat {
 namespace testing {
 namespace internal {
 
+class PerfImpl;
+
 //===----------------------------------------------------------------------===//
 // Perf
 //===----------------------------------------------------------------------===//
-class Perf
+/** \class Perf
+ *  \brief Perf counts a group of perf events.
+ *
+ *  All events of a Perf are opened as one perf_event group, so they start and
+ *  stop together and are read by a single read(). When the mmap pages of the
+ *  events allow, the counters are read by rdpmc in user space instead.
+ *
+ *  A thread opens the group of a list of events on the first Perf of that
+ *  list, and every later Perf reuses it. The group never stops counting; a
+ *  Perf keeps the counters it started from and takes its own deltas, so
+ *  nested regions and regions of other threads don't disturb it. Once no
+ *  Perf uses a group, only a few of the most recently used such groups are
+ *  kept open, so that they don't keep competing for the counters.
+ *
+ *  The counters of a Perf are kept in the storage given to it, which is a
+ *  vector of its own unless a StaticPerf gives inline storage.
+ */
+class Perf : private Uncopyable
 {
+public:
+  typedef std::vector<enum PerfEvent> EventList;
+
 public:
   Perf();
   Perf(enum PerfEvent pEvent);
+  Perf(const EventList& pEvents);
   ~Perf();
 
   bool isActive() const { return m_bIsActive; }
-  testing::Interval interval() const { return m_Interval; }
-  testing::Interval eventType() const { return m_EventType; }
+
+  unsigned int size() const { return m_Size; }
+
+  /// @return the counted number of the pIdx-th event.
+  testing::Interval interval(unsigned int pIdx = 0) const {
+    return m_pIntervals[pIdx];
+  }
+
+  /// @return the type of the pIdx-th event.
+  testing::Interval eventType(unsigned int pIdx = 0) const {
+    return m_pEvents[pIdx];
+  }
+
+  /// @return the part of the time between start() and stop() the group was
+  /// really counting. The kernel multiplexes groups that ask for more
+  /// counters than the PMU has; their intervals are then scaled up, and are
+  /// estimates rather than exact counts. 1 if the group was not multiplexed.
+  double ratio() const { return m_Ratio; }
 
   void start();
   void stop();
 
+  /// snapshot - read the counts since start() without stopping, and
+  /// without the paused counts. Multiplexed groups are not scaled.
+  /// @param pCounts the counts of every event.
+  void snapshot(testing::Interval* pCounts) const;
+
+  /// pause - stop counting until resume(). The counts while paused are left
+  /// out of the intervals.
+  void pause();
+  void resume();
+
+  /// @return "rdpmc" if the counters have been read in user space, or
+  /// "read" if they have been read by the read() system call.
+  std::string readPath() const;
+
   static std::string unit();
 
+  /// @return how the pIdx-th event is counted: "perf" by perf_event. When
+  /// perf_event_open is denied, "cputime" for the clocks read by
+  /// clock_gettime, "rusage" for the faults and context switches read by
+  /// getrusage, or "none" if the event is left out and reads zero.
+  std::string backend(unsigned int pIdx = 0) const;
+
+  /// probe - try to open the event alone in the calling thread.
+  /// @return the backend that would count the event, as backend() does.
+  static std::string probe(enum PerfEvent pEvent);
+
+  /// paranoid - read /proc/sys/kernel/perf_event_paranoid.
+  /// @return false if the system does not tell.
+  static bool paranoid(int& pLevel);
+
+  /// addEvent - parse a raw event, such as "r01c2", an event of a PMU, such
+  /// as "cpu/event=0xd1,umask=0x20/", or the name of an event under
+  /// /sys/bus/event_source/devices/<pmu>/events, and give it a number after
+  /// the predefined events. Adding the same string again gives the same
+  /// number.
+  /// @return false if the string is malformed or names no known event.
+  static bool addEvent(const std::string& pName, enum PerfEvent& pEvent);
+
+  /// name - the name of a predefined event, or the string of an added one.
+  static std::string name(testing::Interval pEvent);
+
+  /// closeIdleGroups - close the groups of the calling thread no Perf uses,
+  /// such as those of a calibration.
+  static void closeIdleGroups();
+
+  /// The number of intervals the storage of pSize events takes.
+  static unsigned int storageSize(unsigned int pSize) { return 4 * pSize; }
+
+protected:
+  /// Count the events in the storage of the caller, which outlives the
+  /// Perf and holds storageSize(pSize) intervals.
+  /// @param pGroup the group of the events of the calling thread.
+  Perf(const enum PerfEvent* pEvents, unsigned int pSize,
+       testing::Interval* pStorage, PerfImpl& pGroup);
+
+  /// group - the group of the events in the calling thread, opened on the
+  /// first call. The group stays open for the life of the thread.
+  static PerfImpl& group(const enum PerfEvent* pEvents, unsigned int pSize);
+
 private:
-  testing::Interval m_Interval, m_EventType;
+  /// bind - lay out the counters in pStorage and clear them.
+  void bind(testing::Interval* pStorage);
+
+private:
+  EventList m_EventStorage;
+  std::vector<testing::Interval> m_Storage;
+  const enum PerfEvent* m_pEvents;
+  unsigned int m_Size;
+  testing::Interval* m_pIntervals;
+  testing::Interval* m_pPauseStarts;
+  testing::Interval* m_pPaused;
+  testing::Interval* m_pStarts;
+  testing::Interval m_StartEnabled;
+  testing::Interval m_StartRunning;
+  PerfImpl* m_pImpl;
+  double m_Ratio;
   bool m_bIsActive;
 };
 
+//===----------------------------------------------------------------------===//
+// StaticPerf
+//===----------------------------------------------------------------------===//
+/** \class StaticPerfStorage
+ *  \brief StaticPerfStorage is the inline storage of a StaticPerf. It is a
+ *  base class, so it is constructed before the Perf that uses it.
+ */
+template<unsigned int Size>
+class StaticPerfStorage
+{
+protected:
+  std::array<testing::Interval, 4 * Size> m_Counters;
+};
+
+/** \class StaticPerf
+ *  \brief StaticPerf counts a set of events known at compile time.
+ *
+ *  The counters live inline, so a StaticPerf allocates nothing, and the
+ *  group of the events is looked up once per thread instead of once per
+ *  Perf.
+ */
+template<enum PerfEvent First, enum PerfEvent... Rest>
+class StaticPerf : private StaticPerfStorage<1 + sizeof...(Rest)>,
+                   public Perf
+{
+public:
+  static const unsigned int kSize = 1 + sizeof...(Rest);
+
+public:
+  StaticPerf()
+    : StaticPerfStorage<kSize>(),
+      Perf(kEvents, kSize, this->m_Counters.data(), ThisThreadGroup()) { }
+
+private:
+  static PerfImpl& ThisThreadGroup() {
+    static thread_local PerfImpl* group = NULL;
+    if (NULL == group)
+      group = &Perf::group(kEvents, kSize);
+    return *group;
+  }
+
+private:
+  static const enum PerfEvent kEvents[kSize];
+};
+
+template<enum PerfEvent First, enum PerfEvent... Rest>
+const enum PerfEvent StaticPerf<First, Rest...>::kEvents[] = { First, Rest... };
+
 } // namespace of internal
 } // namespace of testing
 } // namespace of skypat
@@ -0,0 +1,61 @@
+//===- Sampler.h ----------------------------------------------------------===//
+//
+//                     The SkyPat Team
+//
+// This file is distributed under the New BSD License. 
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#ifndef SKYPAT_SUPPORT_SAMPLER_H
+#define SKYPAT_SUPPORT_SAMPLER_H
+#include <skypat/skypat.h>
+#include <vector>
+
+namespace skypat {
+namespace testing {
+namespace internal {
+
+class SamplerImpl;
+
+/** \class Sampler
+ *  \brief Sampler samples the call chains of the calling thread.
+ *
+ *  The CPU clock of the thread overflows every period and the kernel writes
+ *  the instruction pointer and the user-space call chain into a ring buffer
+ *  shared with us. drain() moves the samples out of the ring buffer, and
+ *  profile() symbolizes them.
+ */
+class Sampler
+{
+public:
+  /// @param pPeriod the CPU time between samples, in nanoseconds.
+  explicit Sampler(testing::Interval pPeriod);
+  ~Sampler();
+
+  /// @return false if the system can not sample the thread.
+  bool isOpened() const;
+
+  void start();
+
+  /// stop - stop sampling and drain the ring buffer.
+  void stop();
+
+  /// drain - move the samples out of the ring buffer.
+  void drain();
+
+  /// @return the samples counted by the functions they were taken in.
+  testing::Profile profile() const;
+
+private:
+  SamplerImpl* m_pImpl;
+
+  // every chain is its length followed by its addresses, innermost first
+  std::vector<uint64_t> m_Chains;
+  uint64_t m_Lost;
+};
+
+} // namespace of internal
+} // namespace of testing
+} // namespace of skypat
+
+#endif
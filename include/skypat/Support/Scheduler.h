@@ -0,0 +1,52 @@
+//===- Scheduler.h --------------------------------------------------------===//
+//
+//                     The SkyPat Team
+//
+// This file is distributed under the New BSD License. 
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#ifndef SKYPAT_SUPPORT_SCHEDULER_H
+#define SKYPAT_SUPPORT_SCHEDULER_H
+#include <skypat/skypat.h>
+#include <string>
+#include <vector>
+
+namespace skypat {
+namespace testing {
+namespace internal {
+
+/** \class Scheduler
+ *  \brief Scheduler places the calling thread on CPUs and sets its
+ *  scheduling policy.
+ */
+class Scheduler
+{
+public:
+  typedef std::vector<int> CPUList;
+
+public:
+  /// setAffinity - run the calling thread only on the CPUs.
+  /// @return false if the system refuses.
+  static bool setAffinity(const CPUList& pCPUs);
+
+  /// setRealTime - schedule the calling thread by SCHED_FIFO.
+  /// @return false if the system refuses, usually for lack of privilege.
+  static bool setRealTime(int pPriority);
+
+  /// @return the CPU the calling thread runs on, or -1 if unknown.
+  static int currentCPU();
+
+  /// parse - parse a list of CPUs, such as "0,2-3".
+  /// @return false if the list is malformed.
+  static bool parse(const std::string& pList, CPUList& pCPUs);
+
+  /// toString - format a sorted list of CPUs, such as "0,2-3".
+  static std::string toString(const CPUList& pCPUs);
+};
+
+} // namespace of internal
+} // namespace of testing
+} // namespace of skypat
+
+#endif
@@ -0,0 +1,101 @@
+//===- Symbolizer.h -------------------------------------------------------===//
+//
+//                     The SkyPat Team
+//
+// This file is distributed under the New BSD License. 
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#ifndef SKYPAT_SUPPORT_SYMBOLIZER_H
+#define SKYPAT_SUPPORT_SYMBOLIZER_H
+#include <skypat/skypat.h>
+#include <skypat/Thread/Mutex.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace skypat {
+namespace testing {
+namespace internal {
+
+/** \class Symbolizer
+ *  \brief Symbolizer names the functions of code addresses of the process.
+ *
+ *  The mappings of the process come from /proc/self/maps, and the symbols
+ *  from the ELF symbol tables of the mapped files. Every file is read once
+ *  and cached for the rest of the process.
+ */
+class Symbolizer : private Uncopyable
+{
+public:
+  struct Mapping
+  {
+    uint64_t start;
+    uint64_t end;
+    uint64_t offset;
+    std::string path;
+  };
+
+  struct Segment
+  {
+    uint64_t offset;
+    uint64_t address;
+    uint64_t size;
+  };
+
+  struct Symbol
+  {
+    uint64_t address;
+    uint64_t size;
+    std::string name;
+
+    bool operator<(const Symbol& pOther) const {
+      return address < pOther.address;
+    }
+  };
+
+  struct Module
+  {
+    std::vector<Segment> segments;
+    std::vector<Symbol> symbols;
+  };
+
+public:
+  /// self - the symbolizer of the process.
+  static Symbolizer& self();
+
+  /// symbolize - name the function an address is in. Return addresses point
+  /// after their call, so they are looked up one byte before.
+  /// @return the demangled function, "[file]" if the file has no symbol of
+  /// the address, or "[unknown]" if no file maps it.
+  std::string symbolize(uint64_t pAddress, bool pIsReturnAddress = false);
+
+private:
+  typedef std::map<std::string, Module> ModuleMap;
+
+private:
+  Symbolizer();
+
+  /// findMapping - the mapping of an address. The maps are read again once
+  /// if the address is in none of them, as libraries may be loaded later.
+  const Mapping* findMapping(uint64_t pAddress);
+
+  /// module - the segments and the symbols of a file, read on first use.
+  const Module& module(const std::string& pPath);
+
+  // the platform-specific parts
+  void loadMappings();
+  static void loadModule(const std::string& pPath, Module& pModule);
+  static std::string demangle(const std::string& pName);
+
+private:
+  std::vector<Mapping> m_Mappings;
+  ModuleMap m_Modules;
+  Mutex m_Mutex;
+};
+
+} // namespace of internal
+} // namespace of testing
+} // namespace of skypat
+
+#endif
@@ -29,13 +29,50 @@ public:
   void start();
   void stop();
 
+  /// @return the time since start(), without the paused time. Only valid
+  /// while the timer is active and not paused.
+  testing::Interval elapsed() const;
+
+  /// pause - stop counting until resume(). The paused time is left out of
+  /// the interval.
+  void pause();
+  void resume();
+
   static std::string unit();
 
+  /// @return "perf" if the calling thread is timed by the task clock of
+  /// perf_event, read in user space through its mmap page. "cputime" if
+  /// perf_event_open is denied or the page doesn't give the time, and the
+  /// CPU time of the thread is read by clock_gettime instead, or "clock" if
+  /// the system has no perf_event.
+  static std::string backend();
+
 private:
   testing::Interval m_Interval;
+  testing::Interval m_PauseStart;
   bool m_bIsActive;
 };
 
+//===----------------------------------------------------------------------===//
+// CycleClock
+//===----------------------------------------------------------------------===//
+/** \class CycleClock
+ *  \brief CycleClock is a monotonic clock cheap enough to be read once per
+ *  iteration.
+ *
+ *  It reads the time-stamp counter on x86 and clock_gettime elsewhere. Unlike
+ *  Timer, it counts wall-clock time.
+ */
+class CycleClock
+{
+public:
+  /// @return the current tick.
+  static uint64_t now();
+
+  /// @return the nanoseconds of a tick. The first call calibrates it.
+  static double nsPerTick();
+};
+
 } // namespace of internal
 } // namespace of testing
 } // namespace of skypat
@@ -0,0 +1,42 @@
+//===- Barrier.h ----------------------------------------------------------===//
+//
+//                              The SkyPat team 
+//
+// This file is distributed under the New BSD License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#ifndef SKYPAT_THREAD_BARRIER_H
+#define SKYPAT_THREAD_BARRIER_H
+#include <skypat/ADT/Uncopyable.h>
+#include <skypat/Thread/Mutex.h>
+#include <skypat/Thread/WaitCondition.h>
+
+namespace skypat {
+
+/** \class Barrier
+ *  \brief Barrier holds a number of threads until all of them arrive.
+ *
+ *  A barrier can be reused. Once all threads arrive, they are released
+ *  together and the barrier waits for the next round.
+ */
+class Barrier : private Uncopyable
+{
+public:
+  /// @param pCount the number of threads of every round.
+  explicit Barrier(unsigned int pCount);
+
+  /// wait - wait until all threads of the round arrive.
+  void wait();
+
+private:
+  Mutex m_Mutex;
+  WaitCondition m_Condition;
+  unsigned int m_Count;
+  unsigned int m_Waiting;
+  unsigned int m_Generation;
+};
+
+} // namespace of skypat
+
+#endif
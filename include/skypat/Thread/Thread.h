@@ -9,6 +9,7 @@
 #ifndef SKYPAT_THREAD_THREAD_H
 #define SKYPAT_THREAD_THREAD_H
 #include <skypat/SkypatNamespace.h>
+#include <vector>
 
 namespace skypat {
 
@@ -34,6 +35,13 @@ public:
 
   HANDLE getThreadID() const;
 
+  /// setAffinity - run the thread only on the CPUs. Takes effect on start.
+  void setAffinity(const std::vector<int>& pCPUs);
+
+  /// setRealTime - schedule the thread by SCHED_FIFO at the priority. Zero
+  /// keeps the default scheduler. Takes effect on start.
+  void setRealTime(int pPriority);
+
 protected:
   friend class ThreadImpl;
 
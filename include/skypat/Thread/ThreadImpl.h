@@ -12,8 +12,9 @@
 #include <skypat/ADT/TypeTraits.h>
 #include <skypat/Thread/Thread.h>
 #include <skypat/Thread/Mutex.h>
-//#include <skypat/Thread/WaitCondition.h>
+#include <skypat/Thread/WaitCondition.h>
 #include <skypat/Config/Config.h>
+#include <vector>
 
 #if defined(HAVE_PTHREAD)
 #include <pthread.h>
@@ -75,6 +76,9 @@ public:
 
   ThreadData* data;
   Thread* parent;
+
+  std::vector<int> cpus;
+  int priority;
 };
 
 } // namespace of skypat
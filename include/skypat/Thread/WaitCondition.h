@@ -0,0 +1,45 @@
+//===- WaitCondition.h ----------------------------------------------------===//
+//
+//                              The SkyPat team 
+//
+// This file is distributed under the New BSD License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#ifndef SKYPAT_THREAD_WAIT_CONDITION_H
+#define SKYPAT_THREAD_WAIT_CONDITION_H
+#include <skypat/ADT/Uncopyable.h>
+
+namespace skypat {
+
+class Mutex;
+class WaitConditionData;
+
+/** \class WaitCondition
+ *  \brief The WaitCondition class provides a condition variable for
+ *  synchronizing threads.
+ */
+class WaitCondition : private Uncopyable
+{
+public:
+  WaitCondition();
+
+  ~WaitCondition();
+
+  /// wait - release the locked mutex and wait for a wake-up. The mutex is
+  /// locked again before returning.
+  void wait(Mutex& pMutex) throw();
+
+  /// wakeOne - wake up one of the waiting threads.
+  void wakeOne() throw();
+
+  /// wakeAll - wake up all the waiting threads.
+  void wakeAll() throw();
+
+private:
+  WaitConditionData* m_pData;
+};
+
+} // namespace of skypat
+
+#endif
@@ -12,12 +12,13 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <initializer_list>
 #include <skypat/Support/OStrStream.h>
 
 #define SKYPAT_VERNUM 0x24
 
 namespace skypat {
-enum PerfEvent {
+enum PerfEvent : int {
 // type is PERF_TYPE_HARDWARE
   CPU_CYCLES, // = 0
   INSTRUCTIONS,
@@ -41,9 +42,32 @@ enum PerfEvent {
   EMULATION_FAULTS // = 18
 };
 
-enum PerfEventCache{
-// type is PERF_TYPE_HW_CACHE
-// TODO: add CPU cache events
+// type is PERF_TYPE_HW_CACHE. Every cache has the accesses and the misses of
+// reads, writes and prefetches, in the order of the kernel's cache ids,
+// operations and results. Not every CPU counts all of them. The numbers go
+// on after the dummy software event, so they index Perf_event_name as well.
+enum PerfEventCache : int {
+  L1D_READ_ACCESS = 20, L1D_READ_MISS,
+  L1D_WRITE_ACCESS, L1D_WRITE_MISS,
+  L1D_PREFETCH_ACCESS, L1D_PREFETCH_MISS,
+  L1I_READ_ACCESS, L1I_READ_MISS,
+  L1I_WRITE_ACCESS, L1I_WRITE_MISS,
+  L1I_PREFETCH_ACCESS, L1I_PREFETCH_MISS,
+  LL_READ_ACCESS, LL_READ_MISS,
+  LL_WRITE_ACCESS, LL_WRITE_MISS,
+  LL_PREFETCH_ACCESS, LL_PREFETCH_MISS,
+  DTLB_READ_ACCESS, DTLB_READ_MISS,
+  DTLB_WRITE_ACCESS, DTLB_WRITE_MISS,
+  DTLB_PREFETCH_ACCESS, DTLB_PREFETCH_MISS,
+  ITLB_READ_ACCESS, ITLB_READ_MISS,
+  ITLB_WRITE_ACCESS, ITLB_WRITE_MISS,
+  ITLB_PREFETCH_ACCESS, ITLB_PREFETCH_MISS,
+  BPU_READ_ACCESS, BPU_READ_MISS,
+  BPU_WRITE_ACCESS, BPU_WRITE_MISS,
+  BPU_PREFETCH_ACCESS, BPU_PREFETCH_MISS,
+  NODE_READ_ACCESS, NODE_READ_MISS,
+  NODE_WRITE_ACCESS, NODE_WRITE_MISS,
+  NODE_PREFETCH_ACCESS, NODE_PREFETCH_MISS // = 61
 };
 
 extern char const *Perf_event_name[];
@@ -54,6 +78,7 @@ namespace testing {
 namespace internal {
 class Timer;
 class Perf;
+class Sampler;
 
 //===----------------------------------------------------------------------===//
 // ADT
@@ -106,6 +131,23 @@ skypat::testing::TestInfo* const SKYPAT_TEST_CLASS_NAME_(case_name, test_name)\
             SKYPAT_TEST_CLASS_NAME_(case_name, test_name)>);\
 void SKYPAT_TEST_CLASS_NAME_(case_name, test_name)::TestBody()
 
+/// Helper macro for defining Cases which run once per argument of a set.
+#define SKYPAT_PARAM_TEST_CASE(case_name, test_name, parent_class, arg_set)\
+class SKYPAT_TEST_CLASS_NAME_(case_name, test_name) : public parent_class {\
+ public:\
+  SKYPAT_TEST_CLASS_NAME_(case_name, test_name)() {}\
+ private:\
+  virtual void TestBody();\
+  static skypat::testing::TestInfo* const m_TestInfo;\
+};\
+\
+skypat::testing::TestInfo* const SKYPAT_TEST_CLASS_NAME_(case_name, test_name)\
+  ::m_TestInfo =\
+    skypat::testing::MakeAndRegisterParamTestInfos<\
+        SKYPAT_TEST_CLASS_NAME_(case_name, test_name)>(\
+            #case_name, #test_name, arg_set);\
+void SKYPAT_TEST_CLASS_NAME_(case_name, test_name)::TestBody()
+
 /// Helper macro for defining SystemC Cases.
 #define SKYPAT_SYSTEMC_TEST_CASE(case_name, test_name, parent_class)\
 class SKYPAT_TEST_CLASS_NAME_(case_name, test_name) : public parent_class {\
@@ -187,6 +229,554 @@ void SKYPAT_TEST_CLASS_NAME_(case_name, test_name)::TestBody()
 /// Interval - the unit of time.
 typedef uint64_t Interval;
 
+/** \class Warmup
+ *  \brief Warmup describes the untimed stage before a PERFORM region is
+ *  measured.
+ *
+ *  The warmup runs at least the given number of iterations and at least for
+ *  the given time. It pays for cold caches, first-touch page faults and lazy
+ *  binding, so that they don't show up in the measured samples.
+ */
+class Warmup
+{
+public:
+  /// @param pIterations the minimum number of untimed iterations.
+  /// @param pTime the minimum untimed time, in nanoseconds.
+  explicit Warmup(uint64_t pIterations = 0, Interval pTime = 0)
+    : m_Iterations(pIterations), m_Time(pTime) { }
+
+  uint64_t iterations() const { return m_Iterations; }
+  Interval time() const { return m_Time; }
+
+  bool isEnabled() const { return (0 != m_Iterations || 0 != m_Time); }
+
+private:
+  uint64_t m_Iterations;
+  Interval m_Time;
+};
+
+/** \class Latency
+ *  \brief Latency asks a PERFORM region to time every iteration alone.
+ *
+ *  After the samples, the region runs the given number of iterations once
+ *  more and records the latency of each of them into a Histogram.
+ */
+class Latency
+{
+public:
+  /// @param pIterations the number of timed iterations. Zero means as many
+  /// as all samples together.
+  explicit Latency(uint64_t pIterations = 0) : m_Iterations(pIterations) { }
+
+  uint64_t iterations() const { return m_Iterations; }
+
+private:
+  uint64_t m_Iterations;
+};
+
+/** \class Sampling
+ *  \brief Sampling asks a PERFORM region to profile where its time goes.
+ *
+ *  For the lifetime of the region, the CPU clock of the thread interrupts
+ *  it at the given period and records the instruction pointer and the call
+ *  chain. The samples are symbolized into a Profile of hot functions.
+ */
+class Sampling
+{
+public:
+  /// @param pPeriod the CPU time between samples, in nanoseconds. Zero
+  /// turns sampling off.
+  explicit Sampling(Interval pPeriod = 0) : m_Period(pPeriod) { }
+
+  Interval period() const { return m_Period; }
+
+  bool isEnabled() const { return 0 != m_Period; }
+
+private:
+  Interval m_Period;
+};
+
+/** \class Throughput
+ *  \brief Throughput declares the work a single iteration of a PERFORM
+ *  region does.
+ *
+ *  The work is given in bytes and in items, such as records or messages.
+ *  Reporters divide it by the corrected time and cycles of an iteration.
+ */
+class Throughput
+{
+public:
+  /// @param pBytes the number of bytes processed by an iteration.
+  /// @param pItems the number of items processed by an iteration.
+  explicit Throughput(uint64_t pBytes = 0, uint64_t pItems = 0)
+    : m_Bytes(pBytes), m_Items(pItems) { }
+
+  uint64_t bytes() const { return m_Bytes; }
+  uint64_t items() const { return m_Items; }
+
+  bool isEnabled() const { return (0 != m_Bytes || 0 != m_Items); }
+
+  Throughput& operator+=(const Throughput& pOther) {
+    m_Bytes += pOther.m_Bytes;
+    m_Items += pOther.m_Items;
+    return *this;
+  }
+
+private:
+  uint64_t m_Bytes;
+  uint64_t m_Items;
+};
+
+/** \class RawEvent
+ *  \brief RawEvent is a PMU event given by a string rather than PerfEvent.
+ *
+ *  The string is a raw event, such as "r01c2", an event of a PMU, such as
+ *  "cpu/event=0xd1,umask=0x20/", or the name of an event listed under
+ *  /sys/bus/event_source/devices/<pmu>/events. It is parsed once, and the
+ *  event is given a PerfEvent number of its own that PERFORM counts like
+ *  any other event.
+ */
+class RawEvent
+{
+public:
+  explicit RawEvent(const std::string& pName);
+
+  const std::string& name() const { return m_Name; }
+
+  /// @return false if the string is malformed or names no known event.
+  bool isValid() const { return m_bIsValid; }
+
+  /// The PerfEvent number of the event. Only valid if isValid().
+  enum PerfEvent event() const { return m_Event; }
+
+private:
+  std::string m_Name;
+  enum PerfEvent m_Event;
+  bool m_bIsValid;
+};
+
+/** \class RunOptions
+ *  \brief RunOptions holds the run-time settings of performance tests.
+ */
+class RunOptions
+{
+public:
+  RunOptions();
+
+  /// The minimum measured time of a PERFORM region, in nanoseconds. PERFORM
+  /// keeps growing the number of iterations until a batch runs this long.
+  Interval getMinTime() const { return m_MinTime; }
+  void setMinTime(Interval pMinTime) { m_MinTime = pMinTime; }
+
+  /// The upper bound of the number of iterations of a PERFORM region.
+  uint64_t getMaxIterations() const { return m_MaxIterations; }
+  void setMaxIterations(uint64_t pMaxIterations) {
+    m_MaxIterations = pMaxIterations;
+  }
+
+  /// The fixed number of iterations of every sample. A PERFORM region
+  /// neither warms up nor calibrates then. Zero calibrates.
+  uint64_t getIterations() const { return m_Iterations; }
+  void setIterations(uint64_t pIterations) { m_Iterations = pIterations; }
+
+  /// The number of samples of a PERFORM region. Every sample runs the
+  /// calibrated number of iterations.
+  unsigned int getRepetitions() const { return m_Repetitions; }
+  void setRepetitions(unsigned int pRepetitions) {
+    m_Repetitions = pRepetitions;
+  }
+
+  /// The warmup of PERFORM regions which don't set their own.
+  const Warmup& getWarmup() const { return m_Warmup; }
+  void setWarmup(const Warmup& pWarmup) { m_Warmup = pWarmup; }
+
+  /// The CPUs the runner and the PERFORM_THREADS workers are pinned to.
+  /// Empty if nothing is pinned.
+  const std::vector<int>& getCPUs() const { return m_CPUs; }
+  void setCPUs(const std::vector<int>& pCPUs) { m_CPUs = pCPUs; }
+
+  /// The SCHED_FIFO priority of the runner and the workers. Zero keeps the
+  /// default scheduler.
+  int getRealTimePriority() const { return m_RealTimePriority; }
+  void setRealTimePriority(int pPriority) { m_RealTimePriority = pPriority; }
+
+  /// The sampling of PERFORM regions which don't set their own.
+  const Sampling& getSampling() const { return m_Sampling; }
+  void setSampling(const Sampling& pSampling) { m_Sampling = pSampling; }
+
+  /// The events every PERFORM region counts in addition to its own.
+  const std::vector<enum PerfEvent>& getEvents() const { return m_Events; }
+  void setEvents(const std::vector<enum PerfEvent>& pEvents) {
+    m_Events = pEvents;
+  }
+  void addEvent(enum PerfEvent pEvent) { m_Events.push_back(pEvent); }
+
+private:
+  Interval m_MinTime;
+  uint64_t m_MaxIterations;
+  uint64_t m_Iterations;
+  unsigned int m_Repetitions;
+  Warmup m_Warmup;
+  std::vector<int> m_CPUs;
+  int m_RealTimePriority;
+  std::vector<enum PerfEvent> m_Events;
+  Sampling m_Sampling;
+};
+
+/** \class Overhead
+ *  \brief Overhead is the per-iteration cost of an empty PERFORM region.
+ *
+ *  UnitTest calibrates it before running the tests, by timing an empty
+ *  PERFORM body with the timer and with every predefined perf event and
+ *  every event of the run, such as those given by -e. Results are then
+ *  reported both raw and with the overhead subtracted. A body that only
+ *  pauses and resumes gives the cost of a pause, which is subtracted once
+ *  per pause.
+ */
+class Overhead
+{
+public:
+  Overhead();
+
+  /// calibrate - measure the empty PERFORM body.
+  void calibrate(const RunOptions& pOptions);
+
+  bool isCalibrated() const { return m_bIsCalibrated; }
+
+  /// The per-iteration overhead of the timer, in nanoseconds.
+  double timer() const { return m_Timer; }
+
+  /// The per-iteration overhead of a perf event. Zero if the event is not
+  /// calibrated.
+  double event(Interval pEventType) const;
+
+  /// @return true if the event is calibrated. Events known only to their
+  /// regions, such as cache events, are not.
+  bool hasEvent(Interval pEventType) const;
+
+  /// The cost of a PauseTiming and ResumeTiming pair that is left in the
+  /// timer and in a perf event.
+  double pauseTimer() const { return m_PauseTimer; }
+  double pauseEvent(Interval pEventType) const;
+
+private:
+  typedef std::map<Interval, double> EventMap;
+
+private:
+  double m_Timer;
+  EventMap m_Events;
+  double m_PauseTimer;
+  EventMap m_PauseEvents;
+  bool m_bIsCalibrated;
+};
+
+/** \class Statistics
+ *  \brief Statistics summarizes a set of samples.
+ *
+ *  Besides mean and standard deviation, Statistics gives the robust
+ *  estimators (median and MAD), a Student's t confidence interval of the
+ *  mean, and classifies outliers by Tukey's fences.
+ */
+class Statistics
+{
+public:
+  enum Outlier {
+    kLowSevere,   ///< below Q1 - 3 IQR
+    kLowMild,     ///< below Q1 - 1.5 IQR
+    kHighMild,    ///< above Q3 + 1.5 IQR
+    kHighSevere,  ///< above Q3 + 3 IQR
+    kNumOfOutlierKinds
+  };
+
+public:
+  Statistics();
+
+  /// compute - summarize the samples.
+  void compute(const std::vector<double>& pSamples);
+
+  unsigned int size() const { return m_Size; }
+
+  double mean()   const { return m_Mean; }
+  double median() const { return m_Median; }
+  double stddev() const { return m_StdDev; }
+
+  /// The median absolute deviation from the median.
+  double mad() const { return m_MAD; }
+
+  double min() const { return m_Min; }
+  double max() const { return m_Max; }
+
+  /// @return true if there are enough samples for a confidence interval.
+  bool hasInterval() const { return 1 < m_Size; }
+
+  /// The bounds of the 95% confidence interval of the mean.
+  double lowerBound() const { return m_LowerBound; }
+  double upperBound() const { return m_UpperBound; }
+
+  /// @return the number of outliers of the kind.
+  unsigned int outliers(Outlier pKind) const { return m_Outliers[pKind]; }
+
+  /// @return the number of outliers of all kinds.
+  unsigned int outliers() const;
+
+private:
+  unsigned int m_Size;
+  double m_Mean;
+  double m_Median;
+  double m_StdDev;
+  double m_MAD;
+  double m_Min;
+  double m_Max;
+  double m_LowerBound;
+  double m_UpperBound;
+  unsigned int m_Outliers[kNumOfOutlierKinds];
+};
+
+/** \class Histogram
+ *  \brief Histogram is a log-linear histogram of latencies in nanoseconds.
+ *
+ *  Like HdrHistogram, values below 2^kPrecision are counted exactly, and
+ *  every power of two above is split into 2^(kPrecision-1) linear buckets,
+ *  which bounds the relative error by 2^(1-kPrecision). The buckets are
+ *  allocated once by reset(), so record() never allocates, and histograms
+ *  with the same layout merge by adding bucket counts.
+ */
+class Histogram
+{
+public:
+  enum {
+    kPrecision = 7,
+    kNumOfBuckets = (1 << kPrecision) + (64 - kPrecision) * (1 << (kPrecision - 1))
+  };
+
+public:
+  Histogram();
+
+  /// reset - allocate the buckets and forget all values.
+  void reset();
+
+  bool empty() const { return 0 == m_Count; }
+
+  /// record - count a value. The histogram must be reset() before.
+  void record(uint64_t pValue) {
+    ++m_Buckets[index(pValue)];
+    ++m_Count;
+    m_Sum += pValue;
+    if (pValue < m_Min)
+      m_Min = pValue;
+    if (pValue > m_Max)
+      m_Max = pValue;
+  }
+
+  /// merge - add the counts of another histogram.
+  void merge(const Histogram& pOther);
+
+  uint64_t count() const { return m_Count; }
+  uint64_t min() const { return empty() ? 0 : m_Min; }
+  uint64_t max() const { return m_Max; }
+  double mean() const { return empty() ? 0.0 : double(m_Sum) / m_Count; }
+
+  /// @return the value below which pP percents of the values fall. The
+  /// value is the highest one of its bucket, never beyond the maximum.
+  uint64_t percentile(double pP) const;
+
+  /// @return the bucket of a value.
+  static unsigned int index(uint64_t pValue) {
+    if (pValue < (1ULL << kPrecision))
+      return pValue;
+    unsigned int shift = 64 - kPrecision - __builtin_clzll(pValue);
+    return (1 << kPrecision) + (shift - 1) * (1 << (kPrecision - 1)) +
+           (pValue >> shift) - (1 << (kPrecision - 1));
+  }
+
+  /// @return the highest value of a bucket.
+  static uint64_t upperBound(unsigned int pIndex);
+
+private:
+  std::vector<uint64_t> m_Buckets;
+  uint64_t m_Count;
+  uint64_t m_Sum;
+  uint64_t m_Min;
+  uint64_t m_Max;
+};
+
+/// ArgList - the arguments of one instance of a parameterized test.
+typedef std::vector<int64_t> ArgList;
+
+/** \class Profile
+ *  \brief Profile counts the samples of functions.
+ *
+ *  A sample is a call chain, innermost function first. The function a
+ *  sample stops in gets a self sample, and every function on the chain gets
+ *  a total sample once. The chains are also kept as folded stacks, the
+ *  outermost function first and the frames separated by ';', as flame graph
+ *  tools read them.
+ */
+class Profile
+{
+public:
+  struct Entry
+  {
+    std::string function;
+    uint64_t self;
+    uint64_t total;
+  };
+
+  typedef std::vector<Entry> EntryList;
+
+  /// folded stack "main;foo;bar" -> number of samples
+  typedef std::map<std::string, uint64_t> StackMap;
+
+public:
+  Profile();
+
+  /// addSample - count a call chain, innermost function first.
+  void addSample(const std::vector<std::string>& pChain);
+
+  /// addLost - count the samples the kernel dropped.
+  void addLost(uint64_t pLost) { m_Lost += pLost; }
+
+  /// merge - add the counts of another profile.
+  void merge(const Profile& pOther);
+
+  bool empty() const { return 0 == m_Samples; }
+  uint64_t samples() const { return m_Samples; }
+  uint64_t lost() const { return m_Lost; }
+
+  /// top - the functions with the most self samples, at most pN of them.
+  EntryList top(unsigned int pN) const;
+
+  /// stacks - the folded stacks of the samples.
+  const StackMap& stacks() const { return m_Stacks; }
+
+private:
+  typedef std::map<std::string, Entry> EntryMap;
+
+private:
+  EntryMap m_Entries;
+  StackMap m_Stacks;
+  uint64_t m_Samples;
+  uint64_t m_Lost;
+};
+
+/** \class ArgSet
+ *  \brief ArgSet is the set of arguments a parameterized test runs with.
+ *
+ *  Every ArgList of the set becomes an instance of the test. skypat::Range,
+ *  skypat::DenseRange, skypat::Values and skypat::Product build the sets.
+ */
+class ArgSet
+{
+public:
+  typedef std::vector<ArgList> ArgLists;
+  typedef ArgLists::const_iterator const_iterator;
+
+public:
+  ArgSet() { }
+
+  const_iterator begin() const { return m_ArgLists.begin(); }
+  const_iterator end()   const { return m_ArgLists.end(); }
+
+  unsigned int size() const { return m_ArgLists.size(); }
+  bool empty() const { return m_ArgLists.empty(); }
+
+  ArgSet& add(const ArgList& pArgs) {
+    m_ArgLists.push_back(pArgs);
+    return *this;
+  }
+
+  ArgSet& add(int64_t pArg) { return add(ArgList(1, pArg)); }
+
+private:
+  ArgLists m_ArgLists;
+};
+
+/** \class Complexity
+ *  \brief Complexity fits measured costs to the common asymptotic
+ *  complexities.
+ *
+ *  For every candidate f(n), the least-squares coefficient c of cost = c f(n)
+ *  is computed, and the candidate with the lowest RMS error wins. The RMS
+ *  error is relative to the mean cost.
+ */
+class Complexity
+{
+public:
+  enum BigO {
+    kO1,
+    kOLogN,
+    kON,
+    kONLogN,
+    kON2,
+    kNumOfBigOs
+  };
+
+public:
+  Complexity();
+
+  /// fit - fit the costs measured with the sizes.
+  void fit(const std::vector<double>& pSizes,
+           const std::vector<double>& pCosts);
+
+  BigO bigO() const { return m_BigO; }
+  double coefficient() const { return m_Coefficient; }
+  double rms() const { return m_RMS; }
+
+  /// @return the name of a complexity, such as "O(n log n)".
+  static const char* name(BigO pBigO);
+
+private:
+  BigO m_BigO;
+  double m_Coefficient;
+  double m_RMS;
+};
+
+/** \class Scalability
+ *  \brief Scalability fits the throughputs of 1, 2, ... N threads to the
+ *  Universal Scalability Law.
+ *
+ *  The law models the throughput of N threads as
+ *
+ *    X(N) = lambda N / (1 + sigma (N - 1) + kappa N (N - 1)),
+ *
+ *  where sigma is the contention (the serialized part) and kappa is the
+ *  coherency (the cost of keeping threads consistent). With kappa above
+ *  zero, the throughput peaks and then falls. Sigma is at most 1, where
+ *  the work is serialized as a whole and the fit is saturated.
+ */
+class Scalability
+{
+public:
+  Scalability();
+
+  /// fit - fit the throughputs measured with the numbers of threads. The
+  /// numbers must include one thread.
+  void fit(const std::vector<double>& pThreads,
+           const std::vector<double>& pThroughputs);
+
+  /// @return true if there were enough numbers of threads to fit.
+  bool isFitted() const { return m_bIsFitted; }
+
+  double lambda() const { return m_Lambda; }
+  double sigma() const { return m_Sigma; }
+  double kappa() const { return m_Kappa; }
+
+  /// @return true if sigma is clamped to 1: more threads never run faster
+  /// than one.
+  bool isSaturated() const { return m_bIsSaturated; }
+
+  /// @return the number of threads of the highest modeled throughput, or
+  /// zero if the throughput never falls or the fit is saturated.
+  double peak() const;
+
+private:
+  double m_Lambda;
+  double m_Sigma;
+  double m_Kappa;
+  bool m_bIsFitted;
+  bool m_bIsSaturated;
+};
+
 //===----------------------------------------------------------------------===//
 // Core
 //===----------------------------------------------------------------------===//
@@ -201,9 +791,112 @@ template<typename SingleTest> struct TestFactory : public TestFactoryBase {
   virtual skypat::Test* CreateTest() { return new SingleTest; }
 };
 
+/** \class PerfSpec
+ *  \brief PerfSpec describes what a PERFORM region measures and how.
+ *
+ *  The arguments of PERFORM are folded into a PerfSpec one by one, so a
+ *  region accepts its settings in any order.
+ */
+class PerfSpec
+{
+public:
+  PerfSpec();
+
+  explicit PerfSpec(enum PerfEvent pEvent);
+
+  /// The events to count as a group. Empty means the default event.
+  const std::vector<enum PerfEvent>& events() const { return m_Events; }
+
+  /// @return true if the region sets its own warmup.
+  bool hasWarmup() const { return m_bHasWarmup; }
+  const Warmup& warmup() const { return m_Warmup; }
+
+  /// @return true if the region records the latency of every iteration.
+  bool hasLatency() const { return m_bHasLatency; }
+  const Latency& latency() const { return m_Latency; }
+
+  /// The work of an iteration. Bytes and Items of a region add up.
+  const Throughput& throughput() const { return m_Throughput; }
+
+  /// @return true if the region sets its own sampling.
+  bool hasSampling() const { return m_bHasSampling; }
+  const Sampling& sampling() const { return m_Sampling; }
+
+  /// The name of the region given by PERFORM_NAMED, or empty.
+  const std::string& name() const { return m_Name; }
+  void setName(const std::string& pName) { m_Name = pName; }
+
+  void add(enum PerfEvent pEvent) { m_Events.push_back(pEvent); }
+  void add(enum PerfEventCache pEvent) {
+    m_Events.push_back(static_cast<enum PerfEvent>(pEvent));
+  }
+  void add(const RawEvent& pEvent);
+  void add(const Sampling& pSampling) {
+    m_Sampling = pSampling;
+    m_bHasSampling = true;
+  }
+  void add(const Warmup& pWarmup) { m_Warmup = pWarmup; m_bHasWarmup = true; }
+  void add(const Latency& pLatency) {
+    m_Latency = pLatency;
+    m_bHasLatency = true;
+  }
+  void add(const Throughput& pThroughput) { m_Throughput += pThroughput; }
+
+private:
+  std::vector<enum PerfEvent> m_Events;
+  Warmup m_Warmup;
+  bool m_bHasWarmup;
+  Latency m_Latency;
+  bool m_bHasLatency;
+  Throughput m_Throughput;
+  Sampling m_Sampling;
+  bool m_bHasSampling;
+  std::string m_Name;
+};
+
+inline void AddToPerfSpec(PerfSpec&) { }
+
+template<typename Arg, typename... Args>
+void AddToPerfSpec(PerfSpec& pSpec, const Arg& pArg, const Args&... pArgs)
+{
+  pSpec.add(pArg);
+  AddToPerfSpec(pSpec, pArgs...);
+}
+
+/// MakePerfSpec - fold the arguments of PERFORM into a PerfSpec.
+template<typename... Args>
+PerfSpec MakePerfSpec(const Args&... pArgs)
+{
+  PerfSpec spec;
+  AddToPerfSpec(spec, pArgs...);
+  return spec;
+}
+
+/// MakeNamedPerfSpec - fold the arguments of PERFORM_NAMED, whose first
+/// argument is the name of the region, into a PerfSpec.
+template<typename... Args>
+PerfSpec MakeNamedPerfSpec(const std::string& pName, const Args&... pArgs)
+{
+  PerfSpec spec = MakePerfSpec(pArgs...);
+  spec.setName(pName);
+  return spec;
+}
+
 /** \class PerfIterator
  *  \brief PerfIterator is used to calculate the computing time of a
  *  performance test.
+ *
+ *  A PERFORM region goes through three phases. The warmup runs untimed
+ *  iterations, the calibration grows the number of iterations until a batch
+ *  is long enough, and the sampling takes the measured samples. A region
+ *  given skypat::LatencyHistogram() finally times its iterations one by
+ *  one.
+ *
+ *  A PERFORM inside the body of another is a phase of it rather than a
+ *  region on its own. Its body runs once for every iteration of the outer
+ *  region, and its costs are summed up over the batch and sampled with the
+ *  batch, so that every region of the tree has the inclusive costs of its
+ *  body and the exclusive costs without its nested regions.
  */
 class PerfIterator
 {
@@ -220,20 +913,225 @@ public:
   PerfIterator(const char* pFileName, int pLoC,\
                enum PerfEvent pEvent);
 
+  /// @param pFileName the source file name.
+  /// @param pLoC the line of code.
+  /// @param pSpec the settings of the region.
+  PerfIterator(const char* pFileName, int pLoC, const PerfSpec& pSpec);
+
+  /// @param pFileName the source file name.
+  /// @param pLoC the line of code.
+  /// @param pArgs the events and settings of the region.
+  template<typename... Args>
+  PerfIterator(const char* pFileName, int pLoC, const Args&... pArgs)
+    : PerfIterator(pFileName, pLoC, MakePerfSpec(pArgs...)) { }
+
+  /// Measure into pResult instead of a new result of the running test.
+  /// @param pResult the result to fill.
+  /// @param pSpec the settings of the region.
+  /// @param pOptions the run-time settings used instead of UnitTest's,
+  /// which outlive the iterator.
+  PerfIterator(PerfPartResult& pResult, const PerfSpec& pSpec,
+               const RunOptions& pOptions);
+
+  /// Measure by the timer and the counters of the caller, which outlive the
+  /// iterator, instead of allocating them. The events of the run are not
+  /// added to pPerf. A nested region allocates its counters all the same
+  /// if pPerf misses an event of its parent.
+  /// @param pFileName the source file name.
+  /// @param pLoC the line of code.
+  /// @param pSpec the settings of the region.
+  PerfIterator(const char* pFileName, int pLoC, const PerfSpec& pSpec,
+               internal::Timer& pTimer, internal::Perf& pPerf);
+
   /// Destructor. The place to sum up the time.
   ~PerfIterator();
 
-  /// increase counter
-  PerfIterator& next();
+  /// increase counter. Once the region has laps, the rest of every
+  /// iteration after its last lap is a phase, too.
+  PerfIterator& next() {
+    ++m_Counter;
+    if (m_bHasLaps)
+      endLaps();
+    return *this;
+  }
 
   /// @return true if we should go to the next step.
-  bool hasNext() const;
+  /// The fast path is inlined so that tiny kernels are not dominated by the
+  /// cost of the loop condition.
+  bool hasNext() { return (m_Counter < m_Iterations) || nextBatch(); }
+
+  /// pause - stop the timer and every perf counter of the region until
+  /// resume(). Pauses don't nest.
+  void pause();
+  void resume();
+
+  /// lap - end the phase of the iteration that began at the previous lap,
+  /// or at the start of the iteration. The laps of the warmup, of the
+  /// latencies and of nested regions are ignored.
+  void lap(const char* pName);
+
+  /// @return the innermost region running on the calling thread, or NULL.
+  static PerfIterator* current();
+
+private:
+  enum Phase {
+    kWarmup,
+    kCalibrate,
+    kSample,
+    kLatency,
+    kNested
+  };
+
+  /// The counters of a nested region and its costs, summed up over the
+  /// current batch. The outermost region owns the counters; NULL stands for
+  /// the counters of the caller.
+  struct NestedRegion
+  {
+    PerfPartResult* result;
+    internal::Timer* timer;
+    internal::Perf* perf;
+    Interval time;
+    std::vector<Interval> types;
+    std::vector<Interval> events;
+  };
+
+  typedef std::vector<NestedRegion> NestedList;
+
+  /// The costs of a phase between laps, summed up over the current batch.
+  struct LapTotal
+  {
+    std::string name;
+    Interval time;
+    std::vector<Interval> events;
+  };
+
+  typedef std::vector<LapTotal> LapList;
+
+private:
+  /// nextBatch - close the current batch of iterations. While the batches
+  /// run shorter than the minimum measured time, grow the number of
+  /// iterations. Once calibrated, every batch is a sample of the
+  /// per-iteration cost.
+  /// @return true if a new batch is started.
+  bool nextBatch();
+
+  /// warmUp - close a batch of the warmup.
+  void warmUp();
+
+  /// timeIteration - record the latency of the last iteration.
+  /// @return true if more iterations are timed.
+  bool timeIteration();
+
+  /// findNested - @return the nested region of pResult, or NULL before its
+  /// first run.
+  NestedRegion* findNested(const PerfPartResult* pResult);
+
+  /// sampleNested - take a sample of every nested region from the costs of
+  /// the batch, and the exclusive sample of this region.
+  /// @param pTime, pEvents the per-iteration costs of this region.
+  void sampleNested(double pTime, const std::vector<double>& pEvents);
+
+  /// exclude - subtract the per-iteration costs of the regions nested
+  /// directly in pResult. An event is subtracted only if the nested region
+  /// counts it, too.
+  void exclude(const PerfPartResult& pResult,
+               const std::vector<Interval>& pTypes,
+               double& pTime, std::vector<double>& pEvents) const;
+
+  /// resetNested - forget the costs of the batch.
+  void resetNested();
+
+  /// finishNested - summarize the samples of every nested region.
+  void finishNested();
+
+  /// endLaps - end the last phase of the iteration.
+  void endLaps();
+
+  /// sampleLaps - take a sample of every phase from the costs of the batch.
+  void sampleLaps();
+
+  /// resetLaps - forget the costs of the batch.
+  void resetLaps();
+
+  /// initCounters - allocate the timer and the perf counters the caller
+  /// doesn't provide.
+  void initCounters(const PerfSpec& pSpec, const RunOptions& pOptions);
+
+  /// resultOf - the result of the region at pFile:pLine. A nested region
+  /// gets the same result on every run of its parent.
+  static PerfPartResult& resultOf(const char* pFile, int pLine);
+
+  /// @param pTimer, pPerf the counters of the caller, or NULL to allocate
+  /// them.
+  PerfIterator(PerfPartResult& pResult, const PerfSpec& pSpec,
+               const RunOptions& pOptions, internal::Timer* pTimer,
+               internal::Perf* pPerf);
 
 private:
-  int m_Counter;
+  uint64_t m_Counter;
+  uint64_t m_Iterations;
+  Phase m_Phase;
+  const RunOptions& m_Options;
+  Warmup m_Warmup;
+  Latency m_Latency;
+  bool m_bHasLatency;
+  uint64_t m_LastTick;
+  uint64_t m_PauseTick;
+  uint64_t m_Pauses;
   internal::Timer* m_pTimer;
   internal::Perf* m_pPerf;
+  internal::Sampler* m_pSampler;
   PerfPartResult* m_pPerfResult;
+  PerfIterator* m_pParent;
+  PerfIterator* m_pRoot;
+  bool m_bOwnsTimer;
+  bool m_bOwnsPerf;
+  NestedList m_Nested;
+  bool m_bHasLaps;
+  LapList m_Laps;
+  unsigned int m_LapIdx;
+  Interval m_LapTime;
+  std::vector<Interval> m_LapEvents;
+  std::vector<Interval> m_LapBuffer;
+};
+
+/** \class ParallelPerformHelper
+ *  \brief ParallelPerformHelper runs the body of PERFORM_THREADS on worker
+ *  threads.
+ *
+ *  A single worker warms up and calibrates the body first. Then, for every
+ *  number of threads from one up to the given number, the worker threads
+ *  warm up, wait at a barrier and measure the body together, each into its
+ *  own PerfPartResult and with the calibrated number of iterations. A result
+ *  that sums up the threads comes before theirs.
+ */
+class ParallelPerformHelper
+{
+public:
+  typedef void (*Invoker)(const void* pBody);
+
+public:
+  ParallelPerformHelper(const char* pFileName, int pLoC,
+                        unsigned int pNumOfThreads, const PerfSpec& pSpec);
+
+  // Body assignment is a semantic trick to take the body of
+  // PERFORM_THREADS as a lambda; see the PERFORM_THREADS macro below.
+  template<typename Body>
+  void operator=(const Body& pBody) { run(&Invoke<Body>, &pBody); }
+
+private:
+  template<typename Body>
+  static void Invoke(const void* pBody) {
+    (*static_cast<const Body*>(pBody))();
+  }
+
+  void run(Invoker pInvoker, const void* pBody);
+
+private:
+  const char* m_FileName;
+  int m_LoC;
+  unsigned int m_NumOfThreads;
+  PerfSpec m_Spec;
 };
 
 /** \class PartResult
@@ -296,18 +1194,297 @@ class PerfPartResult : public PartResult
 public:
   PerfPartResult(const std::string& pFileName, int pLoC);
 
+  /// The timer and event numbers are the medians of the per-iteration
+  /// costs of all samples.
   Interval getTimerNum() const;
-  Interval getPerfEventNum() const;
-  Interval getPerfEventType() const;
+  Interval getPerfEventNum(unsigned int pIdx = 0) const;
+  Interval getPerfEventType(unsigned int pIdx = 0) const;
+
+  /// The per-iteration overheads of an empty PERFORM region.
+  double getTimerOverhead() const { return m_TimerOverhead; }
+  double getPerfEventOverhead(unsigned int pIdx = 0) const;
+
+  /// The number of pauses of an iteration.
+  double getPausesPerIteration() const { return m_PausesPerIteration; }
+
+  /// The medians with the overheads of the region and of its pauses
+  /// subtracted, never below zero.
+  double getCorrectedTimerNum() const;
+  double getCorrectedPerfEventNum(unsigned int pIdx = 0) const;
+
+  /// @return true if the overheads are at least the median, so that the
+  /// corrected number says nothing but that the body is too cheap for its
+  /// region, such as one that pauses around a few nanoseconds of work.
+  bool isTimerBelowOverhead() const;
+  bool isPerfEventBelowOverhead(unsigned int pIdx = 0) const;
+
+  /// @return true if the overhead of the event is known. The corrected
+  /// number of an event that is not calibrated is the raw median.
+  bool isPerfEventCalibrated(unsigned int pIdx = 0) const;
+
+  /// The number of perf events counted together in the region.
+  unsigned int getNumOfPerfEvents() const { return m_PerfEvents.size(); }
+
+  /// The number of iterations of every sample.
+  uint64_t getIterations() const;
+
+  /// The number of untimed iterations before the samples.
+  uint64_t getWarmupIterations() const { return m_WarmupIterations; }
+
+  /// The time of the whole warmup, in nanoseconds.
+  Interval getWarmupTime() const { return m_WarmupTime; }
+
+  /// The time of the very first iteration, in nanoseconds. It is the cost
+  /// of a cold call, as opposed to the steady-state cost of the samples.
+  Interval getFirstCallTime() const { return m_FirstCallTime; }
+
+  /// The latencies of single iterations. Empty unless the region is given
+  /// skypat::LatencyHistogram(), see Latency.
+  const Histogram& getLatency() const { return m_Latency; }
+  Histogram&       getLatency()       { return m_Latency; }
+
+  /// The work of an iteration, as declared by Bytes and Items.
+  const Throughput& getThroughput() const { return m_Throughput; }
+
+  /// The rates of the work, per second of the corrected time. Zero if the
+  /// region declares no such work.
+  double getBytesPerSecond() const;
+  double getItemsPerSecond() const;
+
+  /// The rates of the work, per corrected CPU cycle. Zero unless CPU_CYCLES
+  /// is counted in the group.
+  double getBytesPerCycle() const;
+  double getItemsPerCycle() const;
+
+  /// The iterations per second of the corrected time. The result of several
+  /// threads gives the iterations of all threads per second of wall-clock
+  /// time, so threads that wait for each other or share a core lower it.
+  double getIterationsPerSecond() const;
+
+  /// The number of threads that ran the region together.
+  unsigned int getNumOfThreads() const { return m_NumOfThreads; }
+
+  /// The iterations per second relative to one thread, and the speedup per
+  /// thread. Zero unless the result sums up worker threads.
+  double getSpeedup() const { return m_Speedup; }
+  double getEfficiency() const;
+
+  /// The fit of the whole sweep of thread numbers the result belongs to.
+  const Scalability& getScalability() const { return m_Scalability; }
+
+  /// The index of the thread among them, or -1 if the result is not of a
+  /// single worker thread.
+  int getThreadIndex() const { return m_ThreadIdx; }
+
+  /// The results of every worker thread, if this result sums them up.
+  const std::vector<const PerfPartResult*>& getThreadResults() const {
+    return m_ThreadResults;
+  }
+
+  /// The sorted CPUs the region was seen on at the ends of its batches.
+  /// Empty if the system does not tell.
+  const std::vector<int>& getCPUs() const { return m_CPUs; }
+
+  /// The hot functions of the region, if it is sampled.
+  const Profile& getProfile() const { return m_Profile; }
+
+  /// The lowest part of a sample's time that the perf events were really
+  /// counting. Below 1 the kernel multiplexed the group, and the event
+  /// numbers are scaled estimates rather than exact counts.
+  double getRunningRatio() const { return m_RunningRatio; }
+  bool isMultiplexed() const { return (1.0 > m_RunningRatio); }
+
+  /// How the counters were read: "rdpmc" in user space, or "read".
+  const std::string& getReadPath() const { return m_ReadPath; }
+
+  /// What counted the region: "perf" if the timer and every event are
+  /// perf_event, else the backends of the timer and the events joined by
+  /// '+', such as "cputime+rusage+none". See internal::Perf::backend().
+  const std::string& getBackend() const { return m_Backend; }
+
+  /// The per-iteration costs of every sample.
+  const std::vector<double>& getTimerSamples() const { return m_TimerSamples; }
+  const std::vector<double>& getPerfEventSamples(unsigned int pIdx = 0) const {
+    return m_PerfEvents[pIdx].samples;
+  }
+
+  const Statistics& getTimerStats() const { return m_TimerStats; }
+  const Statistics& getPerfEventStats(unsigned int pIdx = 0) const {
+    return m_PerfEvents[pIdx].stats;
+  }
+
+  /// The name given by PERFORM_NAMED, or empty.
+  const std::string& getName() const { return m_Name; }
+
+  /// The region within its test: the name, or the line if the region is
+  /// not named. A nested region follows the region of its parent, after
+  /// a '/', such as "request/decode".
+  std::string getRegion() const;
+
+  /// The phases between the SKYPAT_LAP markers of the region, in the order
+  /// they first ended. Like those of the region, the costs of a phase are
+  /// per iteration, one sample per sample of the region.
+  unsigned int getNumOfLaps() const { return m_Laps.size(); }
+  const std::string& getLapName(unsigned int pIdx) const {
+    return m_Laps[pIdx].name;
+  }
+  const Statistics& getLapTimerStats(unsigned int pIdx) const {
+    return m_Laps[pIdx].stats;
+  }
+  const Statistics& getLapPerfEventStats(unsigned int pLap,
+                                         unsigned int pIdx = 0) const {
+    return m_Laps[pLap].event_stats[pIdx];
+  }
+
+  /// The region this one is nested in, or NULL.
+  const PerfPartResult* getParent() const { return m_pParentResult; }
+
+  /// The number of regions this one is nested in.
+  unsigned int getDepth() const { return m_Depth; }
+
+  /// The regions nested directly in this one, in the order they first ran.
+  const std::vector<PerfPartResult*>& getChildren() const {
+    return m_Children;
+  }
+
+  bool hasChildren() const { return !m_Children.empty(); }
+
+  /// The per-iteration costs of the region without those of its nested
+  /// regions. The same as the inclusive statistics if nothing is nested.
+  const Statistics& getExclusiveTimerStats() const;
+  const Statistics& getExclusivePerfEventStats(unsigned int pIdx = 0) const;
 
   void setTimerNum(Interval pTime);
-  void setPerfEventNum(Interval pEventNum);
-  void setPerfEventType(Interval pEventType);
+  void addPerfEvent(Interval pEventType);
+  void setIterations(uint64_t pIterations);
+  void setWarmup(uint64_t pIterations, Interval pTime);
+  void setFirstCallTime(Interval pTime) { m_FirstCallTime = pTime; }
+  void setReadPath(const std::string& pPath) { m_ReadPath = pPath; }
+  void setBackend(const std::string& pBackend) { m_Backend = pBackend; }
+  void setThroughput(const Throughput& pThroughput) {
+    m_Throughput = pThroughput;
+  }
+  /// addPauses - average the pauses per iteration of a batch with those
+  /// of the batches before.
+  void addPauses(double pPauses) {
+    ++m_PauseBatches;
+    m_PausesPerIteration += (pPauses - m_PausesPerIteration) / m_PauseBatches;
+  }
+  void setThread(unsigned int pNumOfThreads, int pIdx) {
+    m_NumOfThreads = pNumOfThreads;
+    m_ThreadIdx = pIdx;
+  }
+
+  void setIterationsPerSecond(double pRate) { m_IterationsPerSecond = pRate; }
+  void setScalability(double pSpeedup, const Scalability& pScalability) {
+    m_Speedup = pSpeedup;
+    m_Scalability = pScalability;
+  }
+
+  void setProfile(const Profile& pProfile) { m_Profile = pProfile; }
+  void setName(const std::string& pName) { m_Name = pName; }
+
+  /// addChild - nest pChild directly in this region.
+  void addChild(PerfPartResult& pChild);
+
+  /// findChild - @return the region at pFileName:pLoC nested directly in
+  /// this one, or NULL.
+  PerfPartResult* findChild(const char* pFileName, int pLoC) const;
+
+  /// addRunningRatio - note the running ratio of a sample.
+  void addRunningRatio(double pRatio) {
+    if (pRatio < m_RunningRatio)
+      m_RunningRatio = pRatio;
+  }
+
+  /// addCPU - note that the region ran on the CPU. Negative CPUs are
+  /// unknown and ignored.
+  void addCPU(int pCPU);
+
+  /// aggregate - sum up the results of the threads that ran the region
+  /// together. The time and event numbers are the averages of one iteration
+  /// on one thread.
+  void aggregate(const std::vector<const PerfPartResult*>& pThreads);
+
+  /// setOverhead - take the overheads of the timer and the events.
+  void setOverhead(const Overhead& pOverhead);
+
+  /// addSample - add the per-iteration costs of a sample.
+  /// @param pEventNums the per-iteration numbers of every perf event.
+  void addSample(double pTime, const std::vector<double>& pEventNums);
+
+  /// addExclusiveSample - add the per-iteration costs of a sample without
+  /// those of the nested regions.
+  void addExclusiveSample(double pTime, const std::vector<double>& pEventNums);
+
+  /// addLapSample - add the per-iteration costs of the phase pName to the
+  /// sample.
+  void addLapSample(const std::string& pName, double pTime,
+                    const std::vector<double>& pEventNums);
+
+  /// summarize - compute the statistics of all samples.
+  void summarize();
+
+private:
+  struct PerfEventResult
+  {
+    Interval type;
+    Interval num;
+    double overhead;
+    double pause_overhead;
+    bool calibrated;
+    std::vector<double> samples;
+    Statistics stats;
+    std::vector<double> exclusive_samples;
+    Statistics exclusive_stats;
+  };
+
+  typedef std::vector<PerfEventResult> PerfEventList;
+
+  struct LapResult
+  {
+    std::string name;
+    std::vector<double> samples;
+    Statistics stats;
+    std::vector<std::vector<double> > event_samples;
+    std::vector<Statistics> event_stats;
+  };
+
+  typedef std::vector<LapResult> LapList;
 
 private:
   Interval m_PerfTimerNum;
-  Interval m_PerfEventNum;
-  Interval m_PerfEventType;
+  double m_TimerOverhead;
+  double m_PauseOverhead;
+  double m_PausesPerIteration;
+  unsigned int m_PauseBatches;
+  uint64_t m_Iterations;
+  uint64_t m_WarmupIterations;
+  Interval m_WarmupTime;
+  Interval m_FirstCallTime;
+  std::string m_ReadPath;
+  std::string m_Backend;
+  std::vector<double> m_TimerSamples;
+  Statistics m_TimerStats;
+  PerfEventList m_PerfEvents;
+  Histogram m_Latency;
+  Throughput m_Throughput;
+  unsigned int m_NumOfThreads;
+  int m_ThreadIdx;
+  double m_IterationsPerSecond;
+  double m_Speedup;
+  Scalability m_Scalability;
+  std::vector<const PerfPartResult*> m_ThreadResults;
+  std::vector<int> m_CPUs;
+  double m_RunningRatio;
+  Profile m_Profile;
+  std::string m_Name;
+  const PerfPartResult* m_pParentResult;
+  unsigned int m_Depth;
+  std::vector<PerfPartResult*> m_Children;
+  std::vector<double> m_ExclusiveSamples;
+  Statistics m_ExclusiveStats;
+  LapList m_Laps;
 };
 
 /** \class TestResult
@@ -406,6 +1583,23 @@ public:
   const std::string& getTestName() const { return m_TestName; }
   const TestResult& result() const { return m_Result; }
 
+  /// @return the region of a PERFORM of the test, unique within the test.
+  /// It is PerfPartResult::getRegion(), numbered from ~2 on if an earlier
+  /// result of the test has the same region, and followed by @<threads> for
+  /// the results of PERFORM_THREADS and #<index> for those of a single
+  /// worker thread, such as "decode~2" or "decode@4#2".
+  std::string getRegion(const PerfPartResult& pResult) const;
+
+  /// @return the key of a PERFORM region of the test, such as
+  /// "MyCase.test.decode". Unlike the line of the region, the key of a
+  /// named region stays the same across refactorings of the source.
+  std::string getKey(const PerfPartResult& pResult) const;
+
+  /// The arguments of an instance of a parameterized test. Empty for plain
+  /// tests.
+  const ArgList& args() const { return m_Args; }
+  void setArgs(const ArgList& pArgs) { m_Args = pArgs; }
+
   /// run - run a single test function and notifiy repeater.
   void run();
 
@@ -430,6 +1624,7 @@ private:
   std::string m_TestName;
   TestResult m_Result;
   TestFactoryBase* m_pFactory;
+  ArgList m_Args;
   TestPartResultList m_TestResultList;
   PerfPartResultList m_PerfResultList;
 };
@@ -517,6 +1712,28 @@ TestInfo* MakeAndRegisterTestInfo(
     const char* pTestName,
     TestFactoryBase* pFactory);
 
+/// GetParamTestName - the name of an instance, such as "test/8/64".
+std::string GetParamTestName(const char* pTestName, const ArgList& pArgs);
+
+/// MakeAndRegisterParamTestInfos - register an instance of the test for every
+/// argument list of the set.
+/// @return the TestInfo of the last instance.
+template<typename SingleTest>
+TestInfo* MakeAndRegisterParamTestInfos(const char* pCaseName,
+                                        const char* pTestName,
+                                        const ArgSet& pArgSet)
+{
+  TestInfo* info = NULL;
+  ArgSet::const_iterator args, aEnd = pArgSet.end();
+  for (args = pArgSet.begin(); args != aEnd; ++args) {
+    std::string name = GetParamTestName(pTestName, *args);
+    info = MakeAndRegisterTestInfo(pCaseName, name.c_str(),
+                                   new TestFactory<SingleTest>);
+    info->setArgs(*args);
+  }
+  return info;
+}
+
 std::string GetBoolAssertionFailureMessage(
     const AssertionResult& pAssertionResult,
     const char* pExpressionText,
@@ -696,6 +1913,11 @@ public:
   const Repeater& repeater() const { return m_Repeater; }
   Repeater&       repeater()       { return m_Repeater; }
 
+  const RunOptions& options() const { return m_Options; }
+  RunOptions&       options()       { return m_Options; }
+
+  const Overhead& overhead() const { return m_Overhead; }
+
   unsigned int getNumOfCases() const { return m_CaseMap.size(); }
   unsigned int getNumOfTests() const { return m_NumOfTests; }
   unsigned int getNumOfFails() const { return m_NumOfFails; }
@@ -712,6 +1934,8 @@ private:
   CaseMap m_CaseMap;
   RunCases m_RunCases;
   testing::Repeater m_Repeater;
+  testing::RunOptions m_Options;
+  testing::Overhead m_Overhead;
   testing::TestInfo* m_pCurrentInfo;
   unsigned int m_NumOfTests;
   unsigned int m_NumOfFails;
@@ -782,8 +2006,192 @@ public:
   /// @}
 
   virtual void TestBody() = 0;
+
+protected:
+  /// @return the pIdx-th argument of an instance of a parameterized test.
+  int64_t arg(unsigned int pIdx = 0) const;
+
+private:
+  testing::ArgList m_Args;
 };
 
+namespace testing {
+namespace internal {
+/// UseCharPointer - an opaque call, used to keep values alive by compilers
+/// without GNU inline assembly.
+void UseCharPointer(char const volatile* pPointer);
+} // namespace of internal
+} // namespace of testing
+
+/// DoNotOptimize - make the compiler believe that pValue is read, so the
+/// computation of pValue can not be deleted. It doesn't generate any
+/// instruction by itself.
+template<typename T>
+inline void DoNotOptimize(const T& pValue)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  __asm__ __volatile__("" : : "r,m"(pValue) : "memory");
+#else
+  testing::internal::UseCharPointer(
+                           &reinterpret_cast<char const volatile&>(pValue));
+#endif
+}
+
+/// DoNotOptimize - make the compiler believe that pValue is read and may be
+/// written, so neither the computation of pValue nor the code using it
+/// afterward can be folded away.
+template<typename T>
+inline void DoNotOptimize(T& pValue)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  __asm__ __volatile__("" : "+r,m"(pValue) : : "memory");
+#else
+  testing::internal::UseCharPointer(
+                           &reinterpret_cast<char const volatile&>(pValue));
+#endif
+}
+
+/// ClobberMemory - make the compiler believe that all memory may be read and
+/// written here, so pending stores must be done before this point.
+inline void ClobberMemory()
+{
+#if defined(__GNUC__) || defined(__clang__)
+  __asm__ __volatile__("" : : : "memory");
+#else
+  static char const volatile sink = 0;
+  testing::internal::UseCharPointer(&sink);
+#endif
+}
+
+/// Sink - consume the result of a PERFORM body. For example:
+///
+///   PERFORM(skypat::CPU_CYCLES) {
+///     skypat::Sink(fibonacci(10));
+///   }
+///
+/// @return the value itself, so the result is still usable.
+template<typename T>
+inline const T& Sink(const T& pValue)
+{
+  DoNotOptimize(pValue);
+  return pValue;
+}
+
+/// Range - the arguments from pLow to pHigh, multiplied by pMultiplier each
+/// time. pHigh is always included. For example, Range(8, 512) is
+/// {8, 64, 512}.
+testing::ArgSet Range(int64_t pLow, int64_t pHigh, int64_t pMultiplier = 8);
+
+/// PowersOfTwo - the powers of two from pLow to pHigh.
+inline testing::ArgSet PowersOfTwo(int64_t pLow, int64_t pHigh)
+{
+  return Range(pLow, pHigh, 2);
+}
+
+/// DenseRange - the arguments from pLow to pHigh by pStep.
+testing::ArgSet DenseRange(int64_t pLow, int64_t pHigh, int64_t pStep = 1);
+
+/// Values - the given arguments.
+testing::ArgSet Values(std::initializer_list<int64_t> pValues);
+
+/// Product - the cartesian product of two sets. Every argument list of
+/// pFirst is followed by every argument list of pSecond.
+testing::ArgSet Product(const testing::ArgSet& pFirst,
+                        const testing::ArgSet& pSecond);
+
+/// WarmupIterations - run untimed iterations before measuring a PERFORM
+/// region.
+inline testing::Warmup WarmupIterations(uint64_t pIterations)
+{
+  return testing::Warmup(pIterations, 0);
+}
+
+/// WarmupTime - run untimed iterations for milliseconds before measuring a
+/// PERFORM region.
+inline testing::Warmup WarmupTime(double pMS)
+{
+  return testing::Warmup(0, static_cast<testing::Interval>(pMS * 1000000));
+}
+
+/// LatencyHistogram - time every iteration of a PERFORM region alone and
+/// report the percentiles of the latencies.
+/// @param pIterations the number of timed iterations. Zero means as many as
+/// all samples together.
+inline testing::Latency LatencyHistogram(uint64_t pIterations = 0)
+{
+  return testing::Latency(pIterations);
+}
+
+/// OnlineCPUs - the number of CPUs online, at least one.
+unsigned int OnlineCPUs();
+
+/// PauseTiming - stop measuring the running PERFORM region, such as while
+/// the body rebuilds its input. Both the timer and the perf counters stop.
+/// Does nothing outside a PERFORM region.
+///
+/// A pause and its resume read the timer and the counters, which may take
+/// a system call each when the counters can't be read in user space. The
+/// cost is subtracted from the corrected numbers, but the work left
+/// unpaused must be well above it to be measured at all.
+void PauseTiming();
+
+/// ResumeTiming - measure the running PERFORM region again.
+void ResumeTiming();
+
+/// Lap - end a phase of the running PERFORM region. See SKYPAT_LAP. Does
+/// nothing outside a PERFORM region.
+void Lap(const char* pName);
+
+/** \class ScopedPause
+ *  \brief ScopedPause pauses the running PERFORM region in its scope.
+ *
+ *  \code
+ *  PERFORM(skypat::TASK_CLOCK) {
+ *    {
+ *      skypat::ScopedPause pause;
+ *      table.clear();
+ *    }
+ *    table.insert(key);
+ *  }
+ *  \endcode
+ */
+class ScopedPause : private testing::internal::Uncopyable
+{
+public:
+  ScopedPause() { PauseTiming(); }
+  ~ScopedPause() { ResumeTiming(); }
+};
+
+/// Event - count a raw or a sysfs-named PMU event in a PERFORM region, such
+/// as Event("r01c2") or Event("cpu/event=0xd1,umask=0x20/"). A string that
+/// names no event is reported and left out.
+inline testing::RawEvent Event(const std::string& pName)
+{
+  return testing::RawEvent(pName);
+}
+
+/// SamplingProfile - sample where a PERFORM region spends its time, every
+/// given microseconds of CPU time, and report its hot functions. The
+/// interrupts of sampling slightly raise the measured time.
+inline testing::Sampling SamplingProfile(double pUS = 100)
+{
+  return testing::Sampling(static_cast<testing::Interval>(pUS * 1000));
+}
+
+/// Bytes - declare the bytes a single iteration of a PERFORM region
+/// processes. The printers report them per second and per cycle.
+inline testing::Throughput Bytes(uint64_t pBytes)
+{
+  return testing::Throughput(pBytes, 0);
+}
+
+/// Items - declare the items, such as records, a single iteration of a
+/// PERFORM region processes.
+inline testing::Throughput Items(uint64_t pItems)
+{
+  return testing::Throughput(0, pItems);
+}
+
 // Defines a test that uses a test fixture.
 //
 // SKYPAT_C defines a skypat case.
@@ -814,6 +2222,23 @@ public:
 #define SKYPAT_F(test_fixture, test_name) \
   SKYPAT_TEST_CASE(test_fixture, test_name, skypat::Test)
 
+// SKYPAT_P defines a skypat function which runs once per argument list of
+// arg_set. Every instance is a test named test_name/arg/..., and reads its
+// arguments by arg(). For example:
+//
+//   SKYPAT_P(VectorCase, push_back, skypat::Range(8, 8 << 10)) {
+//     std::vector<int> v;
+//     PERFORM(skypat::CPU_CYCLES) {
+//       for (int64_t i = 0; i < arg(0); ++i)
+//         v.push_back(i);
+//     }
+//   }
+//
+// The costs of the instances are fitted to O(1), O(log n), O(n),
+// O(n log n) and O(n^2) of the first argument.
+#define SKYPAT_P(test_fixture, test_name, arg_set) \
+  SKYPAT_PARAM_TEST_CASE(test_fixture, test_name, skypat::Test, arg_set)
+
 #define SKYPAT_SYSTEMC_F(test_fixture, test_name) \
   SKYPAT_SYSTEMC_TEST_CASE(test_fixture, test_name, skypat::Test)
 
@@ -907,11 +2332,62 @@ public:
 #define ASSERT_GT_MSG(actual, expected, mesg) \
   SKYPAT_ASSERT_PRED((actual > expected), actual, expected) << mesg
 
-#define PERFORM(event) \
-  for (skypat::testing::PerfIterator __loop(__FILE__, __LINE__, event); \
+// PERFORM takes perf events and optional settings of the region. All events
+// of a region are counted together as a group, e.g.,
+//
+//   PERFORM(skypat::CPU_CYCLES, skypat::INSTRUCTIONS,
+//           skypat::WarmupIterations(100)) { ... }
+//
+#define PERFORM(...) \
+  for (skypat::testing::PerfIterator __loop(__FILE__, __LINE__, __VA_ARGS__); \
                                                 __loop.hasNext(); \
                                                 __loop.next() )
 
+// PERFORM_NAMED is PERFORM whose first argument names the region. The
+// results of the region are keyed by the name instead of the line, so they
+// stay comparable when the source moves, e.g.,
+//
+//   PERFORM_NAMED("decode", skypat::CPU_CYCLES) { ... }
+//
+#define PERFORM_NAMED(...) \
+  for (skypat::testing::PerfIterator __loop(__FILE__, __LINE__, \
+           skypat::testing::MakeNamedPerfSpec(__VA_ARGS__)); \
+                                                __loop.hasNext(); \
+                                                __loop.next() )
+
+// SKYPAT_LAP ends a phase of the running PERFORM region, which began at the
+// previous lap or at the start of the iteration. The region reports the cost
+// of every phase per iteration, and the rest of the iteration after the last
+// lap as "(rest)". A lap reads the counters once, so it is cheaper than a
+// nested PERFORM, e.g.,
+//
+//   PERFORM(skypat::TASK_CLOCK) {
+//     Parse(request);
+//     SKYPAT_LAP("parse");
+//     Validate(request);
+//     SKYPAT_LAP("validate");
+//   }
+//
+#define SKYPAT_LAP(name) skypat::Lap(name)
+
+// PERFORM_THREADS runs the body on 1, 2, ..., up to the given number of
+// threads, which start together. The body is a lambda, so the statement ends
+// with a semicolon, e.g.,
+//
+//   PERFORM_THREADS(4, skypat::TASK_CLOCK) {
+//     queue.push(1);
+//     queue.pop();
+//   };
+//
+#define PERFORM_THREADS(threads, ...) \
+  skypat::testing::ParallelPerformHelper(__FILE__, __LINE__, threads, \
+      skypat::testing::MakePerfSpec(__VA_ARGS__)) = [&]()
+
+// PERFORM_SCALING is PERFORM_THREADS up to the number of online CPUs. The
+// sweep is fitted to the Universal Scalability Law.
+#define PERFORM_SCALING(...) \
+  PERFORM_THREADS(skypat::OnlineCPUs(), __VA_ARGS__)
+
 } // namespace of skypat
 
 #endif
@@ -0,0 +1,79 @@
+//===- ArgSet.cpp ---------------------------------------------------------===//
+//
+//                     The SkyPat Team
+//
+// This file is distributed under the New BSD License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#include <skypat/skypat.h>
+#include <skypat/Support/OStrStream.h>
+#include <cassert>
+
+using namespace skypat;
+
+//===----------------------------------------------------------------------===//
+// Non-member functions
+//===----------------------------------------------------------------------===//
+testing::ArgSet skypat::Range(int64_t pLow, int64_t pHigh,
+                              int64_t pMultiplier)
+{
+  assert(1 < pMultiplier && "the multiplier of a range must be above one");
+
+  testing::ArgSet result;
+  int64_t arg = pLow;
+  for (; arg < pHigh; arg *= pMultiplier) {
+    result.add(arg);
+    if (0 >= arg)
+      break;
+  }
+  result.add(pHigh);
+  return result;
+}
+
+testing::ArgSet skypat::DenseRange(int64_t pLow, int64_t pHigh,
+                                   int64_t pStep)
+{
+  assert(0 < pStep && "the step of a dense range must be positive");
+
+  testing::ArgSet result;
+  for (int64_t arg = pLow; arg <= pHigh; arg += pStep)
+    result.add(arg);
+  return result;
+}
+
+testing::ArgSet skypat::Values(std::initializer_list<int64_t> pValues)
+{
+  testing::ArgSet result;
+  std::initializer_list<int64_t>::const_iterator value, vEnd = pValues.end();
+  for (value = pValues.begin(); value != vEnd; ++value)
+    result.add(*value);
+  return result;
+}
+
+testing::ArgSet skypat::Product(const testing::ArgSet& pFirst,
+                                const testing::ArgSet& pSecond)
+{
+  testing::ArgSet result;
+  testing::ArgSet::const_iterator first, fEnd = pFirst.end();
+  testing::ArgSet::const_iterator second, sEnd = pSecond.end();
+  for (first = pFirst.begin(); first != fEnd; ++first) {
+    for (second = pSecond.begin(); second != sEnd; ++second) {
+      testing::ArgList args(*first);
+      args.insert(args.end(), second->begin(), second->end());
+      result.add(args);
+    }
+  }
+  return result;
+}
+
+std::string testing::GetParamTestName(const char* pTestName,
+                                      const ArgList& pArgs)
+{
+  std::string result(pTestName);
+  OStrStream OS(result);
+  ArgList::const_iterator arg, aEnd = pArgs.end();
+  for (arg = pArgs.begin(); arg != aEnd; ++arg)
+    OS << "/" << *arg;
+  return result;
+}
@@ -0,0 +1,96 @@
+//===- Complexity.cpp -----------------------------------------------------===//
+//
+//                     The SkyPat Team
+//
+// This file is distributed under the New BSD License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#include <skypat/skypat.h>
+#include <cmath>
+
+using namespace skypat;
+
+//===----------------------------------------------------------------------===//
+// Helper Functions
+//===----------------------------------------------------------------------===//
+/// The candidate function of a complexity.
+static double Evaluate(testing::Complexity::BigO pBigO, double pN)
+{
+  switch (pBigO) {
+    case testing::Complexity::kO1:     return 1.0;
+    case testing::Complexity::kOLogN:  return std::log2(pN);
+    case testing::Complexity::kON:     return pN;
+    case testing::Complexity::kONLogN: return pN * std::log2(pN);
+    case testing::Complexity::kON2:    return pN * pN;
+    default:
+      break;
+  }
+  return 0.0;
+}
+
+//===----------------------------------------------------------------------===//
+// Complexity
+//===----------------------------------------------------------------------===//
+testing::Complexity::Complexity()
+  : m_BigO(kO1), m_Coefficient(0.0), m_RMS(0.0) {
+}
+
+void testing::Complexity::fit(const std::vector<double>& pSizes,
+                              const std::vector<double>& pCosts)
+{
+  *this = Complexity();
+  if (pSizes.empty() || pSizes.size() != pCosts.size())
+    return;
+
+  double mean = 0.0;
+  for (size_t i = 0; i < pCosts.size(); ++i)
+    mean += pCosts[i];
+  mean /= pCosts.size();
+
+  bool is_first = true;
+  for (int candidate = kO1; candidate < kNumOfBigOs; ++candidate) {
+    BigO big_o = static_cast<BigO>(candidate);
+
+    // least squares of cost = c * f(n)
+    double sum_cf = 0.0, sum_ff = 0.0;
+    for (size_t i = 0; i < pSizes.size(); ++i) {
+      double f = Evaluate(big_o, pSizes[i]);
+      sum_cf += pCosts[i] * f;
+      sum_ff += f * f;
+    }
+    if (0.0 == sum_ff)
+      continue;
+    double coefficient = sum_cf / sum_ff;
+
+    double sum_error = 0.0;
+    for (size_t i = 0; i < pSizes.size(); ++i) {
+      double error = pCosts[i] - coefficient * Evaluate(big_o, pSizes[i]);
+      sum_error += error * error;
+    }
+    double rms = std::sqrt(sum_error / pSizes.size());
+    if (0.0 != mean)
+      rms /= mean;
+
+    if (is_first || rms < m_RMS) {
+      m_BigO = big_o;
+      m_Coefficient = coefficient;
+      m_RMS = rms;
+      is_first = false;
+    }
+  }
+}
+
+const char* testing::Complexity::name(BigO pBigO)
+{
+  switch (pBigO) {
+    case kO1:     return "O(1)";
+    case kOLogN:  return "O(log n)";
+    case kON:     return "O(n)";
+    case kONLogN: return "O(n log n)";
+    case kON2:    return "O(n^2)";
+    default:
+      break;
+  }
+  return "O(?)";
+}
@@ -0,0 +1,74 @@
+//===- Histogram.cpp ------------------------------------------------------===//
+//
+//                     The SkyPat Team
+//
+// This file is distributed under the New BSD License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#include <skypat/skypat.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace skypat;
+
+//===----------------------------------------------------------------------===//
+// Histogram
+//===----------------------------------------------------------------------===//
+testing::Histogram::Histogram()
+  : m_Buckets(), m_Count(0), m_Sum(0),
+    m_Min(std::numeric_limits<uint64_t>::max()), m_Max(0) {
+}
+
+void testing::Histogram::reset()
+{
+  m_Buckets.assign(kNumOfBuckets, 0);
+  m_Count = 0;
+  m_Sum = 0;
+  m_Min = std::numeric_limits<uint64_t>::max();
+  m_Max = 0;
+}
+
+void testing::Histogram::merge(const Histogram& pOther)
+{
+  if (pOther.empty())
+    return;
+  if (m_Buckets.empty())
+    reset();
+
+  for (unsigned int i = 0; i < kNumOfBuckets; ++i)
+    m_Buckets[i] += pOther.m_Buckets[i];
+  m_Count += pOther.m_Count;
+  m_Sum += pOther.m_Sum;
+  m_Min = std::min(m_Min, pOther.m_Min);
+  m_Max = std::max(m_Max, pOther.m_Max);
+}
+
+uint64_t testing::Histogram::percentile(double pP) const
+{
+  if (empty())
+    return 0;
+
+  uint64_t rank = static_cast<uint64_t>(std::ceil(pP / 100.0 * m_Count));
+  rank = std::max(rank, uint64_t(1));
+
+  uint64_t seen = 0;
+  for (unsigned int i = 0; i < kNumOfBuckets; ++i) {
+    seen += m_Buckets[i];
+    if (seen >= rank)
+      return std::min(upperBound(i), m_Max);
+  }
+  return m_Max;
+}
+
+uint64_t testing::Histogram::upperBound(unsigned int pIndex)
+{
+  if (pIndex < (1U << kPrecision))
+    return pIndex;
+
+  unsigned int bucket = pIndex - (1U << kPrecision);
+  unsigned int shift = bucket / (1U << (kPrecision - 1)) + 1;
+  uint64_t sub = bucket % (1U << (kPrecision - 1)) + (1U << (kPrecision - 1));
+  return (sub << shift) + ((1ULL << shift) - 1);
+}
@@ -0,0 +1,129 @@
+//===- Overhead.cpp -------------------------------------------------------===//
+//
+//                     The SkyPat Team
+//
+// This file is distributed under the New BSD License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#include <skypat/skypat.h>
+#include <skypat/Support/Perf.h>
+#include <algorithm>
+
+using namespace skypat;
+
+/* Define the longest measured time of a calibrating region (ns) */
+#define SKYPAT_OVERHEAD_MAX_TIME 1000000
+
+/* Define the number of samples of a calibrating region */
+#define SKYPAT_OVERHEAD_REPETITIONS 5
+
+//===----------------------------------------------------------------------===//
+// Helper Functions
+//===----------------------------------------------------------------------===//
+/// Run an empty PERFORM body. ClobberMemory keeps the compiler from folding
+/// the loop, as a real body with side effects would.
+static void RunEmptyRegion(testing::PerfPartResult& pResult,
+                           const testing::PerfSpec& pSpec,
+                           const testing::RunOptions& pOptions)
+{
+  for (testing::PerfIterator loop(pResult, pSpec, pOptions); loop.hasNext();
+       loop.next()) {
+    ClobberMemory();
+  }
+}
+
+/// Run a PERFORM body that only pauses and resumes.
+static void RunPausedRegion(testing::PerfPartResult& pResult,
+                            const testing::PerfSpec& pSpec,
+                            const testing::RunOptions& pOptions)
+{
+  for (testing::PerfIterator loop(pResult, pSpec, pOptions); loop.hasNext();
+       loop.next()) {
+    loop.pause();
+    loop.resume();
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Overhead
+//===----------------------------------------------------------------------===//
+testing::Overhead::Overhead()
+  : m_Timer(0.0), m_Events(), m_PauseTimer(0.0), m_PauseEvents(),
+    m_bIsCalibrated(false) {
+}
+
+void testing::Overhead::calibrate(const RunOptions& pOptions)
+{
+  RunOptions options(pOptions);
+  options.setMinTime(std::min(pOptions.getMinTime(),
+                              Interval(SKYPAT_OVERHEAD_MAX_TIME)));
+  options.setRepetitions(SKYPAT_OVERHEAD_REPETITIONS);
+  options.setWarmup(Warmup(1));
+  options.setEvents(std::vector<enum PerfEvent>());
+  options.setSampling(Sampling());
+
+  // the predefined events and the events of the run, such as those given
+  // by -e
+  std::vector<enum PerfEvent> events;
+  for (int event = CPU_CYCLES; event <= EMULATION_FAULTS; ++event)
+    events.push_back(static_cast<enum PerfEvent>(event));
+  for (unsigned int i = 0; i < pOptions.getEvents().size(); ++i) {
+    enum PerfEvent event = pOptions.getEvents()[i];
+    if (events.end() == std::find(events.begin(), events.end(), event))
+      events.push_back(event);
+  }
+
+  // Every event is calibrated alone. The timer runs in all regions, so its
+  // overhead is the median over all of them. What a pause costs beyond the
+  // empty body is left in the results once per pause.
+  std::vector<double> timer, pause_timer;
+  m_Events.clear();
+  m_PauseEvents.clear();
+  for (unsigned int i = 0; i < events.size(); ++i) {
+    enum PerfEvent event = events[i];
+    PerfSpec spec(event);
+    PerfPartResult result("", 0);
+    RunEmptyRegion(result, spec, options);
+    timer.push_back(result.getTimerStats().median());
+    m_Events[event] = result.getPerfEventStats().median();
+
+    PerfPartResult paused("", 0);
+    RunPausedRegion(paused, spec, options);
+    pause_timer.push_back(std::max(paused.getTimerStats().median() -
+                                   result.getTimerStats().median(), 0.0));
+    m_PauseEvents[event] = std::max(paused.getPerfEventStats().median() -
+                                    result.getPerfEventStats().median(), 0.0);
+  }
+
+  std::sort(timer.begin(), timer.end());
+  m_Timer = timer[timer.size() / 2];
+  std::sort(pause_timer.begin(), pause_timer.end());
+  m_PauseTimer = pause_timer[pause_timer.size() / 2];
+  m_bIsCalibrated = true;
+
+  // a group for every event is open now; don't let them take the counters
+  // of the regions
+  internal::Perf::closeIdleGroups();
+}
+
+double testing::Overhead::event(Interval pEventType) const
+{
+  EventMap::const_iterator event = m_Events.find(pEventType);
+  if (m_Events.end() == event)
+    return 0.0;
+  return event->second;
+}
+
+bool testing::Overhead::hasEvent(Interval pEventType) const
+{
+  return (m_Events.end() != m_Events.find(pEventType));
+}
+
+double testing::Overhead::pauseEvent(Interval pEventType) const
+{
+  EventMap::const_iterator event = m_PauseEvents.find(pEventType);
+  if (m_PauseEvents.end() == event)
+    return 0.0;
+  return event->second;
+}
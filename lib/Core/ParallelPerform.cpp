@@ -0,0 +1,191 @@
+//===- ParallelPerform.cpp ------------------------------------------------===//
+//
+//                     The SkyPat Team
+//
+// This file is distributed under the New BSD License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#include <skypat/skypat.h>
+#include <skypat/Thread/Thread.h>
+#include <skypat/Thread/Barrier.h>
+#include <skypat/Support/Perf.h>
+#include <skypat/Support/Timer.h>
+#include <algorithm>
+#include <unistd.h>
+
+using namespace skypat;
+
+namespace {
+
+/** \class PerformThread
+ *  \brief PerformThread measures the body of PERFORM_THREADS on a worker
+ *  thread.
+ */
+class PerformThread : public skypat::Thread
+{
+public:
+  /// @param pWarmup the number of untimed calls before the barrier.
+  PerformThread(testing::PerfPartResult& pResult,
+                const testing::PerfSpec& pSpec,
+                const testing::RunOptions& pOptions,
+                Barrier& pBarrier,
+                testing::ParallelPerformHelper::Invoker pInvoker,
+                const void* pBody,
+                uint64_t pWarmup)
+    : m_Result(pResult), m_Spec(pSpec), m_Options(pOptions),
+      m_Barrier(pBarrier), m_Invoker(pInvoker), m_pBody(pBody),
+      m_Warmup(pWarmup), m_Calls(0) {
+  }
+
+  /// @return the number of times the body ran after the barrier.
+  uint64_t calls() const { return m_Calls; }
+
+private:
+  void run() {
+    // warm up on the own core, then start together with the other workers
+    for (uint64_t idx = 0; idx < m_Warmup; ++idx)
+      m_Invoker(m_pBody);
+    m_Barrier.wait();
+
+    uint64_t calls = 0;
+    for (testing::PerfIterator loop(m_Result, m_Spec, m_Options);
+         loop.hasNext(); loop.next()) {
+      m_Invoker(m_pBody);
+      ++calls;
+    }
+    m_Calls = calls;
+  }
+
+private:
+  testing::PerfPartResult& m_Result;
+  const testing::PerfSpec& m_Spec;
+  const testing::RunOptions& m_Options;
+  Barrier& m_Barrier;
+  testing::ParallelPerformHelper::Invoker m_Invoker;
+  const void* m_pBody;
+  uint64_t m_Warmup;
+  uint64_t m_Calls;
+};
+
+} // anonymous namespace
+
+//===----------------------------------------------------------------------===//
+// Helper Functions
+//===----------------------------------------------------------------------===//
+/// Pin the pIdx-th worker to one CPU, round robin over the pinned CPUs.
+static void Pin(PerformThread& pWorker, const testing::RunOptions& pOptions,
+                unsigned int pIdx)
+{
+  const std::vector<int>& cpus = pOptions.getCPUs();
+  if (!cpus.empty()) {
+    std::vector<int> cpu(1, cpus[pIdx % cpus.size()]);
+    pWorker.setAffinity(cpu);
+  }
+  pWorker.setRealTime(pOptions.getRealTimePriority());
+}
+
+//===----------------------------------------------------------------------===//
+// Non-member functions
+//===----------------------------------------------------------------------===//
+unsigned int skypat::OnlineCPUs()
+{
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  return (0 < cpus) ? cpus : 1;
+}
+
+//===----------------------------------------------------------------------===//
+// ParallelPerformHelper
+//===----------------------------------------------------------------------===//
+testing::ParallelPerformHelper::ParallelPerformHelper(const char* pFileName,
+                                                      int pLoC,
+                                                      unsigned int pNumOfThreads,
+                                                      const PerfSpec& pSpec)
+  : m_FileName(pFileName), m_LoC(pLoC), m_NumOfThreads(pNumOfThreads),
+    m_Spec(pSpec) {
+}
+
+void testing::ParallelPerformHelper::run(Invoker pInvoker, const void* pBody)
+{
+  UnitTest& unittest = *UnitTest::self();
+  RunOptions options(unittest.options());
+
+  // Warm up and calibrate once, on a single worker. Every worker of the
+  // sweep then runs the same number of iterations without calibrating, so
+  // that only measured iterations run between the barrier and the joins.
+  PerfPartResult calibration(m_FileName, m_LoC);
+
+  // a group that falls back to inherit would be counted by the workers, too
+  internal::Perf::closeIdleGroups();
+  {
+    Barrier barrier(2);
+    PerformThread worker(calibration, m_Spec, options, barrier,
+                         pInvoker, pBody, 0);
+    Pin(worker, options, 0);
+    worker.start();
+    barrier.wait();
+    worker.join();
+  }
+  RunOptions fixed(options);
+  fixed.setIterations(std::max<uint64_t>(calibration.getIterations(), 1));
+  uint64_t warmup = calibration.getWarmupIterations();
+
+  std::vector<PerfPartResult*> totals;
+  for (unsigned int threads = 1; threads <= m_NumOfThreads; ++threads) {
+    PerfPartResult* total = unittest.addPerfPartResult(m_FileName, m_LoC);
+    total->setName(m_Spec.name());
+    totals.push_back(total);
+
+    std::vector<const PerfPartResult*> results;
+    std::vector<PerformThread*> workers;
+    Barrier barrier(threads + 1);
+    for (unsigned int idx = 0; idx < threads; ++idx) {
+      PerfPartResult* result = unittest.addPerfPartResult(m_FileName, m_LoC);
+      result->setThread(threads, idx);
+      results.push_back(result);
+      workers.push_back(new PerformThread(*result, m_Spec, fixed, barrier,
+                                          pInvoker, pBody, warmup));
+      Pin(*workers.back(), options, idx);
+    }
+
+    for (unsigned int idx = 0; idx < threads; ++idx)
+      workers[idx]->start();
+
+    // the wall-clock time from the release of the workers to the end of
+    // the last one
+    barrier.wait();
+    uint64_t start = internal::CycleClock::now();
+    uint64_t calls = 0;
+    for (unsigned int idx = 0; idx < threads; ++idx) {
+      workers[idx]->join();
+      calls += workers[idx]->calls();
+    }
+    double elapsed = (internal::CycleClock::now() - start) *
+                     internal::CycleClock::nsPerTick();
+
+    for (unsigned int idx = 0; idx < threads; ++idx)
+      delete workers[idx];
+
+    total->aggregate(results);
+    if (0.0 < elapsed)
+      total->setIterationsPerSecond(calls * 1e9 / elapsed);
+  }
+
+  if (totals.empty())
+    return;
+
+  // the speedups relative to one thread, and the fit of the whole sweep
+  std::vector<double> threads, throughputs;
+  for (unsigned int idx = 0; idx < totals.size(); ++idx) {
+    threads.push_back(totals[idx]->getNumOfThreads());
+    throughputs.push_back(totals[idx]->getIterationsPerSecond());
+  }
+
+  Scalability scalability;
+  scalability.fit(threads, throughputs);
+  double base = throughputs.front();
+  for (unsigned int idx = 0; idx < totals.size(); ++idx) {
+    double speedup = (0.0 < base) ? throughputs[idx] / base : 0.0;
+    totals[idx]->setScalability(speedup, scalability);
+  }
+}
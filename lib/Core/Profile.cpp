@@ -0,0 +1,99 @@
+//===- Profile.cpp --------------------------------------------------------===//
+//
+//                     The SkyPat Team
+//
+// This file is distributed under the New BSD License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#include <skypat/skypat.h>
+#include <algorithm>
+
+using namespace skypat;
+
+//===----------------------------------------------------------------------===//
+// Helper Functions
+//===----------------------------------------------------------------------===//
+/// Order entries by self samples, then by total samples, then by name.
+static bool HotterThan(const testing::Profile::Entry& pA,
+                       const testing::Profile::Entry& pB)
+{
+  if (pA.self != pB.self)
+    return pA.self > pB.self;
+  if (pA.total != pB.total)
+    return pA.total > pB.total;
+  return pA.function < pB.function;
+}
+
+/// A frame of a folded stack must not contain the separators of the format.
+static std::string FoldFrame(const std::string& pFunction)
+{
+  std::string result(pFunction);
+  std::replace(result.begin(), result.end(), ';', ':');
+  std::replace(result.begin(), result.end(), '\n', ' ');
+  return result;
+}
+
+//===----------------------------------------------------------------------===//
+// Profile
+//===----------------------------------------------------------------------===//
+testing::Profile::Profile()
+  : m_Entries(), m_Stacks(), m_Samples(0), m_Lost(0) {
+}
+
+void testing::Profile::addSample(const std::vector<std::string>& pChain)
+{
+  if (pChain.empty())
+    return;
+  ++m_Samples;
+
+  // a recursive function is on the chain several times, but counts once
+  for (unsigned int i = 0; i < pChain.size(); ++i) {
+    if (pChain.begin() + i != std::find(pChain.begin(), pChain.begin() + i,
+                                        pChain[i]))
+      continue;
+    Entry& entry = m_Entries[pChain[i]];
+    entry.function = pChain[i];
+    entry.self += (0 == i) ? 1 : 0;
+    entry.total += 1;
+  }
+
+  // fold the chain, outermost function first
+  std::string stack;
+  for (unsigned int i = pChain.size(); i > 0; --i) {
+    if (i != pChain.size())
+      stack += ';';
+    stack += FoldFrame(pChain[i - 1]);
+  }
+  m_Stacks[stack] += 1;
+}
+
+void testing::Profile::merge(const Profile& pOther)
+{
+  EntryMap::const_iterator it, iEnd = pOther.m_Entries.end();
+  for (it = pOther.m_Entries.begin(); it != iEnd; ++it) {
+    Entry& entry = m_Entries[it->first];
+    entry.function = it->first;
+    entry.self += it->second.self;
+    entry.total += it->second.total;
+  }
+  StackMap::const_iterator stack, sEnd = pOther.m_Stacks.end();
+  for (stack = pOther.m_Stacks.begin(); stack != sEnd; ++stack)
+    m_Stacks[stack->first] += stack->second;
+
+  m_Samples += pOther.m_Samples;
+  m_Lost += pOther.m_Lost;
+}
+
+testing::Profile::EntryList testing::Profile::top(unsigned int pN) const
+{
+  EntryList result;
+  EntryMap::const_iterator it, iEnd = m_Entries.end();
+  for (it = m_Entries.begin(); it != iEnd; ++it)
+    result.push_back(it->second);
+
+  std::sort(result.begin(), result.end(), HotterThan);
+  if (result.size() > pN)
+    result.resize(pN);
+  return result;
+}
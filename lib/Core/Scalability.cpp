@@ -0,0 +1,84 @@
+//===- Scalability.cpp ----------------------------------------------------===//
+//
+//                     The SkyPat Team
+//
+// This file is distributed under the New BSD License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#include <skypat/skypat.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace skypat;
+
+//===----------------------------------------------------------------------===//
+// Scalability
+//===----------------------------------------------------------------------===//
+testing::Scalability::Scalability()
+  : m_Lambda(0.0), m_Sigma(0.0), m_Kappa(0.0), m_bIsFitted(false),
+    m_bIsSaturated(false) {
+}
+
+void testing::Scalability::fit(const std::vector<double>& pThreads,
+                               const std::vector<double>& pThroughputs)
+{
+  *this = Scalability();
+  for (size_t i = 0; i < pThreads.size(); ++i) {
+    if (1.0 == pThreads[i])
+      m_Lambda = pThroughputs[i];
+  }
+  if (0.0 >= m_Lambda || 3 > pThreads.size())
+    return;
+
+  // With the speedup S = X(N) / X(1), the law is linear in sigma and kappa:
+  //   N / S - 1 = sigma (N - 1) + kappa N (N - 1)
+  double s11 = 0.0, s12 = 0.0, s22 = 0.0, s1y = 0.0, s2y = 0.0;
+  for (size_t i = 0; i < pThreads.size(); ++i) {
+    if (0.0 >= pThroughputs[i])
+      continue;
+    double n = pThreads[i];
+    double y = n * m_Lambda / pThroughputs[i] - 1.0;
+    double x1 = n - 1.0;
+    double x2 = n * (n - 1.0);
+    s11 += x1 * x1;
+    s12 += x1 * x2;
+    s22 += x2 * x2;
+    s1y += x1 * y;
+    s2y += x2 * y;
+  }
+  if (0.0 == s11 || 0.0 == s22)
+    return;
+
+  double det = s11 * s22 - s12 * s12;
+  if (0.0 != det) {
+    m_Sigma = (s1y * s22 - s2y * s12) / det;
+    m_Kappa = (s2y * s11 - s1y * s12) / det;
+  }
+
+  // Both coefficients are costs. If one comes out negative, fit the other
+  // alone.
+  if (0.0 == det || 0.0 > m_Kappa) {
+    m_Kappa = 0.0;
+    m_Sigma = s1y / s11;
+  }
+  if (0.0 > m_Sigma) {
+    m_Sigma = 0.0;
+    m_Kappa = std::max(s2y / s22, 0.0);
+  }
+  // A sigma above 1 means that the threads run slower than serialized
+  // work. Fix it at 1 and fit what is left to kappa.
+  if (1.0 < m_Sigma) {
+    m_Sigma = 1.0;
+    m_Kappa = std::max((s2y - s12) / s22, 0.0);
+    m_bIsSaturated = true;
+  }
+  m_bIsFitted = true;
+}
+
+double testing::Scalability::peak() const
+{
+  if (0.0 >= m_Kappa || 1.0 <= m_Sigma)
+    return 0.0;
+  return std::sqrt((1.0 - m_Sigma) / m_Kappa);
+}
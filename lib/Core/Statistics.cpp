@@ -0,0 +1,123 @@
+//===- Statistics.cpp -----------------------------------------------------===//
+//
+//                     The SkyPat Team
+//
+// This file is distributed under the New BSD License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#include <skypat/skypat.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace skypat;
+
+//===----------------------------------------------------------------------===//
+// Helper Functions
+//===----------------------------------------------------------------------===//
+/// The p-quantile of sorted samples, interpolated linearly between the two
+/// closest ranks.
+static double Quantile(const std::vector<double>& pSorted, double pP)
+{
+  double rank = pP * (pSorted.size() - 1);
+  size_t lower = static_cast<size_t>(rank);
+  if (lower + 1 >= pSorted.size())
+    return pSorted.back();
+  double fraction = rank - lower;
+  return pSorted[lower] + fraction * (pSorted[lower + 1] - pSorted[lower]);
+}
+
+static double Median(std::vector<double>& pSamples)
+{
+  std::sort(pSamples.begin(), pSamples.end());
+  return Quantile(pSamples, 0.5);
+}
+
+/// The 0.975-quantile of Student's t distribution with \p pDF degrees of
+/// freedom. Small degrees come from the table, the others from the
+/// Cornish-Fisher expansion around the normal quantile.
+static double StudentT975(unsigned int pDF)
+{
+  static const double table[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+     2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+     2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+  };
+  const unsigned int size = sizeof(table) / sizeof(table[0]);
+  if (pDF <= size)
+    return table[pDF - 1];
+
+  const double z = 1.959964;
+  double df = pDF;
+  return z + (z * z * z + z) / (4.0 * df) +
+         (5.0 * std::pow(z, 5) + 16.0 * z * z * z + 3.0 * z) /
+         (96.0 * df * df);
+}
+
+//===----------------------------------------------------------------------===//
+// Statistics
+//===----------------------------------------------------------------------===//
+testing::Statistics::Statistics()
+  : m_Size(0), m_Mean(0.0), m_Median(0.0), m_StdDev(0.0), m_MAD(0.0),
+    m_Min(0.0), m_Max(0.0), m_LowerBound(0.0), m_UpperBound(0.0) {
+  std::fill(m_Outliers, m_Outliers + kNumOfOutlierKinds, 0);
+}
+
+void testing::Statistics::compute(const std::vector<double>& pSamples)
+{
+  *this = Statistics();
+  m_Size = pSamples.size();
+  if (pSamples.empty())
+    return;
+
+  std::vector<double> sorted(pSamples);
+  std::sort(sorted.begin(), sorted.end());
+  m_Min = sorted.front();
+  m_Max = sorted.back();
+  m_Median = Quantile(sorted, 0.5);
+
+  double sum = 0.0;
+  for (size_t i = 0; i < sorted.size(); ++i)
+    sum += sorted[i];
+  m_Mean = sum / m_Size;
+
+  double sq_sum = 0.0;
+  std::vector<double> deviations(m_Size);
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    sq_sum += (sorted[i] - m_Mean) * (sorted[i] - m_Mean);
+    deviations[i] = std::fabs(sorted[i] - m_Median);
+  }
+  m_StdDev = (1 < m_Size) ? std::sqrt(sq_sum / (m_Size - 1)) : 0.0;
+  m_MAD = Median(deviations);
+
+  // Tukey's fences
+  double q1 = Quantile(sorted, 0.25);
+  double q3 = Quantile(sorted, 0.75);
+  double iqr = q3 - q1;
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    if (sorted[i] < q1 - 3.0 * iqr)
+      ++m_Outliers[kLowSevere];
+    else if (sorted[i] < q1 - 1.5 * iqr)
+      ++m_Outliers[kLowMild];
+    else if (sorted[i] > q3 + 3.0 * iqr)
+      ++m_Outliers[kHighSevere];
+    else if (sorted[i] > q3 + 1.5 * iqr)
+      ++m_Outliers[kHighMild];
+  }
+
+  // Student's t interval of the mean. Unlike a bootstrap of the median,
+  // it does not collapse to [min, max] when there are only a few samples.
+  if (1 < m_Size) {
+    double half = StudentT975(m_Size - 1) * m_StdDev / std::sqrt(m_Size);
+    m_LowerBound = m_Mean - half;
+    m_UpperBound = m_Mean + half;
+  }
+}
+
+unsigned int testing::Statistics::outliers() const
+{
+  unsigned int result = 0;
+  for (int kind = 0; kind < kNumOfOutlierKinds; ++kind)
+    result += m_Outliers[kind];
+  return result;
+}
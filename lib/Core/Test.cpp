@@ -9,7 +9,9 @@
 #include <skypat/skypat.h>
 #include <skypat/Listeners/PrettyResultPrinter.h>
 #include <skypat/Listeners/CSVResultPrinter.h>
+#include <skypat/Listeners/FlameGraphPrinter.h>
 #include <skypat/Support/Path.h>
+#include <skypat/Support/Scheduler.h>
 #include <time.h>
 #include <cassert>
 #include <unistd.h>
@@ -27,6 +29,26 @@ static inline void help(const int& pArgc, char* pArgv[])
                              << "\t" << pArgv[0] << " [options...]\n\n"
                              << "Options:\n"
                              << "\t-c [file]  toutput CSV to [file]\n"
+                             << "\t-t [ms]    Run each PERFORM for at least [ms]"
+                             << " milliseconds (default: 10)\n"
+                             << "\t-r [n]     Take [n] samples of each PERFORM"
+                             << " (default: 5)\n"
+                             << "\t-w [n]     Run [n] untimed iterations before"
+                             << " each PERFORM (default: 1)\n"
+                             << "\t-W [ms]    Run untimed iterations for [ms]"
+                             << " milliseconds before each PERFORM\n"
+                             << "\t-a [cpus]  Pin the runner and the workers to"
+                             << " [cpus], such as 0,2-3\n"
+                             << "\t-f [prio]  Schedule the runner and the workers"
+                             << " by SCHED_FIFO at [prio]\n"
+                             << "\t-e [event] Count [event] in every PERFORM,"
+                             << " such as r01c2 or\n"
+                             << "\t           cpu/event=0xd1,umask=0x20/"
+                             << " (repeatable)\n"
+                             << "\t-s [us]    Sample every PERFORM each [us]"
+                             << " microseconds and report hot functions\n"
+                             << "\t-g [dir]   Write the folded stacks and flame"
+                             << " graphs of sampled PERFORMs to [dir]\n"
                              << "\t-h         Show this help manual\n";
 }
 
@@ -43,6 +65,12 @@ void Test::run()
   this->TestBody();
 }
 
+int64_t Test::arg(unsigned int pIdx) const
+{
+  assert(pIdx < m_Args.size() && "the test has no such argument");
+  return m_Args[pIdx];
+}
+
 void Test::Initialize(const std::string& pProgName)
 {
   testing::UnitTest::self()->repeater().add(new PrettyResultPrinter());
@@ -74,11 +102,63 @@ void Test::Initialize(const int& pArgc, char* pArgv[])
   // Choose user's printer
   int opt;
   std::string csvFile;
-  while ((opt = getopt(pArgc, pArgv, "c:h")) != -1 ) {
+  std::string flameDir;
+  while ((opt = getopt(pArgc, pArgv, "c:t:r:w:W:a:f:e:s:g:h")) != -1 ) {
     switch (opt) {
       case 'c':
         csvFile = optarg;
         break;
+      case 't':
+        testing::UnitTest::self()->options().setMinTime(
+                                          strtod(optarg, NULL) * 1000000);
+        break;
+      case 'r':
+        testing::UnitTest::self()->options().setRepetitions(atoi(optarg));
+        break;
+      case 'w': {
+        testing::RunOptions& options = testing::UnitTest::self()->options();
+        options.setWarmup(testing::Warmup(strtoull(optarg, NULL, 10),
+                                          options.getWarmup().time()));
+        break;
+      }
+      case 'W': {
+        testing::RunOptions& options = testing::UnitTest::self()->options();
+        options.setWarmup(testing::Warmup(options.getWarmup().iterations(),
+                                          strtod(optarg, NULL) * 1000000));
+        break;
+      }
+      case 'a': {
+        testing::internal::Scheduler::CPUList cpus;
+        if (!testing::internal::Scheduler::parse(optarg, cpus)) {
+          testing::Log::getOStream() << "Bad list of CPUs `" << optarg
+                                     << "`\n";
+          help(pArgc, pArgv);
+          return;
+        }
+        testing::UnitTest::self()->options().setCPUs(cpus);
+        break;
+      }
+      case 'f':
+        testing::UnitTest::self()->options().setRealTimePriority(atoi(optarg));
+        break;
+      case 's':
+        testing::UnitTest::self()->options().setSampling(
+                                    skypat::SamplingProfile(atof(optarg)));
+        break;
+      case 'g':
+        flameDir = optarg;
+        break;
+      case 'e': {
+        testing::RawEvent event(optarg);
+        if (!event.isValid()) {
+          testing::Log::getOStream() << "Unknown perf event `" << optarg
+                                     << "`\n";
+          help(pArgc, pArgv);
+          return;
+        }
+        testing::UnitTest::self()->options().addEvent(event.event());
+        break;
+      }
       case 'h':
       default:
         help(pArgc, pArgv);
@@ -91,6 +171,14 @@ void Test::Initialize(const int& pArgc, char* pArgv[])
   progname = progname.filename();
 
   Initialize(progname.native(), csvFile);
+
+  // flame graphs need samples; sample at the default rate unless -s is given
+  if (!flameDir.empty()) {
+    testing::RunOptions& options = testing::UnitTest::self()->options();
+    if (!options.getSampling().isEnabled())
+      options.setSampling(skypat::SamplingProfile());
+    testing::UnitTest::self()->repeater().add(new FlameGraphPrinter(flameDir));
+  }
 }
 
 void Test::RunAll()
@@ -7,6 +7,7 @@
 //
 //===----------------------------------------------------------------------===//
 #include <skypat/skypat.h>
+#include <skypat/Support/Scheduler.h>
 
 using namespace skypat;
 
@@ -82,6 +83,23 @@ testing::UnitTest::addPerfPartResult(const char* pFile, int pLine)
 
 void testing::UnitTest::RunAll()
 {
+  // place the runner before measuring anything
+  if (!m_Options.getCPUs().empty() &&
+      !internal::Scheduler::setAffinity(m_Options.getCPUs())) {
+    Log(Log::kWarning, __FILE__, __LINE__).getOStream()
+        << "fail to pin the runner to CPUs "
+        << internal::Scheduler::toString(m_Options.getCPUs());
+  }
+  if (0 < m_Options.getRealTimePriority() &&
+      !internal::Scheduler::setRealTime(m_Options.getRealTimePriority())) {
+    Log(Log::kWarning, __FILE__, __LINE__).getOStream()
+        << "fail to schedule the runner by SCHED_FIFO at priority "
+        << m_Options.getRealTimePriority();
+  }
+
+  // measure the framework itself before any test
+  m_Overhead.calibrate(m_Options);
+
   m_Repeater.OnTestProgramStart(*this);
 
   RunCases::iterator iCase, iEnd = m_RunCases.end();
@@ -8,10 +8,123 @@
 //===----------------------------------------------------------------------===//
 #include <skypat/Listeners/CSVResultPrinter.h>
 #include <skypat/ADT/Color.h>
+#include <skypat/Support/OStrStream.h>
+#include <skypat/Support/Perf.h>
+#include <cstdio>
 #include <iostream>
 
 using namespace skypat;
 
+//===----------------------------------------------------------------------===//
+// Helper Functions
+//===----------------------------------------------------------------------===//
+/// Quote a field that holds commas or quotes, such as the name of a PMU
+/// event, cpu/event=0xd1,umask=0x20/, or of a region.
+static std::string Quote(const std::string& pField)
+{
+  if (std::string::npos == pField.find_first_of(",\""))
+    return pField;
+
+  std::string result = "\"";
+  for (unsigned int i = 0; i < pField.size(); ++i) {
+    if ('"' == pField[i])
+      result += '"';
+    result += pField[i];
+  }
+  return result + "\"";
+}
+
+/// The header of the file. The four event columns repeat for every member
+/// of the event group.
+static const char* Header()
+{
+  return "case,test,file,line,key,iterations,samples,"
+         "mean,median,overhead,corrected,stddev,mad,min,max,"
+         "ci_low,ci_high,"
+         "outliers_low_severe,outliers_low_mild,"
+         "outliers_high_mild,outliers_high_severe,"
+         "warmup_iterations,warmup_time,first_call,"
+         "latency_p50,latency_p90,latency_p99,latency_p999,"
+         "latency_max,bytes,items,bytes_per_second,"
+         "items_per_second,bytes_per_cycle,items_per_cycle,"
+         "threads,thread,iterations_per_second,"
+         "speedup,efficiency,usl_sigma,usl_kappa,usl_saturated,"
+         "cpus,read_path,running_ratio,multiplexed,backend,"
+         "parent,depth,exclusive,"
+         "event,event_median,event_corrected,event_exclusive";
+}
+
+/// Move a file aside to the first free name of <name>.1, <name>.2, ...
+/// @return false if it can't be moved.
+static bool Rotate(const std::string& pFileName)
+{
+  for (unsigned int idx = 1; ; ++idx) {
+    std::string rotated;
+    OStrStream OS(rotated);
+    OS << pFileName << "." << idx;
+    std::ifstream file(rotated.c_str());
+    if (!file.is_open())
+      return (0 == std::rename(pFileName.c_str(), rotated.c_str()));
+  }
+}
+
+/// Print the ci_low and ci_high fields, blank if there are too few samples
+/// for a confidence interval.
+static void PrintInterval(std::ostream& pOS, const testing::Statistics& pStats)
+{
+  if (pStats.hasInterval())
+    pOS << pStats.lowerBound() << "," << pStats.upperBound() << ",";
+  else
+    pOS << ",,";
+}
+
+/// Print a row of a phase between the laps of a region. The phase is keyed
+/// as if it were nested in the region, and leaves the columns that belong
+/// to the region alone blank. Phases have no overheads to correct.
+static void PrintLap(std::ostream& pOS, const testing::TestInfo& pTestInfo,
+                     const testing::PerfPartResult& pResult, unsigned int pLap)
+{
+  const testing::Statistics& time = pResult.getLapTimerStats(pLap);
+  pOS << pTestInfo.getCaseName() << ","
+      << pTestInfo.getTestName() << ","
+      << pResult.filename() << ","
+      << pResult.lineNumber() << ","
+      << Quote(pTestInfo.getKey(pResult) + "/" + pResult.getLapName(pLap))
+      << ","
+      << pResult.getIterations() << ","
+      << time.size() << ","
+      << time.mean() << ","
+      << time.median() << ",,,"
+      << time.stddev() << ","
+      << time.mad() << ","
+      << time.min() << ","
+      << time.max() << ",";
+  PrintInterval(pOS, time);
+  pOS << time.outliers(testing::Statistics::kLowSevere) << ","
+      << time.outliers(testing::Statistics::kLowMild) << ","
+      << time.outliers(testing::Statistics::kHighMild) << ","
+      << time.outliers(testing::Statistics::kHighSevere) << ",";
+
+  // no warmup, latencies, throughput, threads, scaling nor CPUs of its own
+  pOS << ",,,,,,,,,,,,,,"
+      << pResult.getNumOfThreads() << ",,,,,,,,,"
+      << pResult.getReadPath() << ","
+      << pResult.getRunningRatio() << ","
+      << (pResult.isMultiplexed() ? 1 : 0) << ","
+      << pResult.getBackend() << ","
+      << Quote(pTestInfo.getRegion(pResult)) << ","
+      << (pResult.getDepth() + 1) << ","
+      << time.median();
+
+  for (unsigned int idx = 0; idx < pResult.getNumOfPerfEvents(); ++idx) {
+    std::string name =
+        testing::internal::Perf::name(pResult.getPerfEventType(idx));
+    double median = pResult.getLapPerfEventStats(pLap, idx).median();
+    pOS << "," << Quote(name) << "," << median << ",," << median;
+  }
+  pOS << std::endl;
+}
+
 //===----------------------------------------------------------------------===//
 // CSVResultPrinter
 //===----------------------------------------------------------------------===//
@@ -30,24 +143,138 @@ bool CSVResultPrinter::open(const std::string& pFileName)
   if (m_OStream.is_open())
     return false;
 
+  // Rows are appended to a file of the same columns only. A file written
+  // by another version, with other columns, is moved aside.
+  bool has_header = false;
+  {
+    std::ifstream file(pFileName.c_str());
+    std::string header;
+    if (file.is_open() && std::getline(file, header)) {
+      has_header = (Header() == header);
+      file.close();
+      if (!has_header && !Rotate(pFileName))
+        return false;
+    }
+  }
+
   m_OStream.open(pFileName.c_str(), std::ostream::out | std::ostream::app);
+  if (m_OStream.good() && !has_header)
+    m_OStream << Header() << std::endl;
   return m_OStream.good();
 }
 
 void CSVResultPrinter::OnTestEnd(const testing::TestInfo& pTestInfo)
 {
-  if (!pTestInfo.result().performance().empty()) {
-    testing::TestResult::Performance::const_iterator perf =
-                                      pTestInfo.result().performance().begin();
-    testing::TestResult::Performance::const_iterator pEnd =
-                                      pTestInfo.result().performance().end();
-    m_OStream << pTestInfo.getTestName() << ",";
-    while (perf != pEnd) {
-      m_OStream << (*perf)->getTimerNum();
-      ++perf;
-      if (perf != pEnd)
-        m_OStream << ",";
+  testing::TestResult::Performance::const_iterator perf =
+                                    pTestInfo.result().performance().begin();
+  testing::TestResult::Performance::const_iterator pEnd =
+                                    pTestInfo.result().performance().end();
+  while (perf != pEnd) {
+    const testing::Statistics& time = (*perf)->getTimerStats();
+    m_OStream << pTestInfo.getCaseName() << ","
+              << pTestInfo.getTestName() << ","
+              << (*perf)->filename() << ","
+              << (*perf)->lineNumber() << ","
+              << Quote(pTestInfo.getKey(**perf)) << ","
+              << (*perf)->getIterations() << ","
+              << time.size() << ","
+              << time.mean() << ","
+              << time.median() << ","
+              << (*perf)->getTimerOverhead() << ",";
+    if ((*perf)->isTimerBelowOverhead())
+      m_OStream << "below overhead";
+    else
+      m_OStream << (*perf)->getCorrectedTimerNum();
+    m_OStream << "," << time.stddev() << ","
+              << time.mad() << ","
+              << time.min() << ","
+              << time.max() << ",";
+    PrintInterval(m_OStream, time);
+    m_OStream << time.outliers(testing::Statistics::kLowSevere) << ","
+              << time.outliers(testing::Statistics::kLowMild) << ","
+              << time.outliers(testing::Statistics::kHighMild) << ","
+              << time.outliers(testing::Statistics::kHighSevere) << ","
+              << (*perf)->getWarmupIterations() << ","
+              << (*perf)->getWarmupTime() << ","
+              << (*perf)->getFirstCallTime() << ",";
+
+    // blank latency columns unless the region records them
+    const testing::Histogram& latency = (*perf)->getLatency();
+    if (latency.empty())
+      m_OStream << ",,,,,";
+    else {
+      m_OStream << latency.percentile(50.0) << ","
+                << latency.percentile(90.0) << ","
+                << latency.percentile(99.0) << ","
+                << latency.percentile(99.9) << ","
+                << latency.max() << ",";
+    }
+
+    const testing::Throughput& throughput = (*perf)->getThroughput();
+    m_OStream << throughput.bytes() << ","
+              << throughput.items() << ","
+              << (*perf)->getBytesPerSecond() << ","
+              << (*perf)->getItemsPerSecond() << ","
+              << (*perf)->getBytesPerCycle() << ","
+              << (*perf)->getItemsPerCycle() << ","
+              << (*perf)->getNumOfThreads() << ",";
+
+    // the thread of a worker, or "all" for the sum of the workers
+    if (-1 != (*perf)->getThreadIndex())
+      m_OStream << (*perf)->getThreadIndex();
+    else if (!(*perf)->getThreadResults().empty())
+      m_OStream << "all";
+    m_OStream << "," << (*perf)->getIterationsPerSecond() << ",";
+
+    // blank scaling columns unless the result sums up worker threads
+    const testing::Scalability& usl = (*perf)->getScalability();
+    if ((*perf)->getThreadResults().empty())
+      m_OStream << ",,";
+    else {
+      m_OStream << (*perf)->getSpeedup() << ","
+                << (*perf)->getEfficiency() << ",";
+    }
+    if (usl.isFitted()) {
+      m_OStream << usl.sigma() << "," << usl.kappa() << ","
+                << (usl.isSaturated() ? 1 : 0) << ",";
+    }
+    else
+      m_OStream << ",,,";
+
+    // the cores the region was seen on, separated by ';'
+    const std::vector<int>& cpus = (*perf)->getCPUs();
+    for (unsigned int idx = 0; idx < cpus.size(); ++idx)
+      m_OStream << (0 == idx ? "" : ";") << cpus[idx];
+    m_OStream << "," << (*perf)->getReadPath() << ","
+              << (*perf)->getRunningRatio() << ","
+              << ((*perf)->isMultiplexed() ? 1 : 0) << ","
+              << (*perf)->getBackend() << ",";
+
+    // the region it is nested in, blank if none
+    if (NULL != (*perf)->getParent())
+      m_OStream << Quote(pTestInfo.getRegion(*(*perf)->getParent()));
+    m_OStream << "," << (*perf)->getDepth() << ","
+              << (*perf)->getExclusiveTimerStats().median();
+
+    // four columns for every member of the event group. The corrected
+    // number is blank unless the overhead of the event is known, and says
+    // "below overhead" if the overhead is at least the median.
+    for (unsigned int idx = 0; idx < (*perf)->getNumOfPerfEvents(); ++idx) {
+      std::string name =
+          testing::internal::Perf::name((*perf)->getPerfEventType(idx));
+      m_OStream << "," << Quote(name)
+                << "," << (*perf)->getPerfEventStats(idx).median() << ",";
+      if ((*perf)->isPerfEventBelowOverhead(idx))
+        m_OStream << "below overhead";
+      else if ((*perf)->isPerfEventCalibrated(idx))
+        m_OStream << (*perf)->getCorrectedPerfEventNum(idx);
+      m_OStream << "," << (*perf)->getExclusivePerfEventStats(idx).median();
     }
     m_OStream << std::endl;
+
+    // a row for every phase between the laps of the region
+    for (unsigned int lap = 0; lap < (*perf)->getNumOfLaps(); ++lap)
+      PrintLap(m_OStream, pTestInfo, **perf, lap);
+    ++perf;
   }
 }
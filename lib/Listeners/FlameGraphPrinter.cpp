@@ -0,0 +1,282 @@
+//===- FlameGraphPrinter.cpp ----------------------------------------------===//
+//
+//                     The SkyPat Team
+//
+// This file is distributed under the New BSD License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#include <skypat/Listeners/FlameGraphPrinter.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using namespace skypat;
+
+/* Define the width of a flame graph, in pixels */
+#define SKYPAT_FLAME_WIDTH 1200
+
+/* Define the height of a frame of a flame graph, in pixels */
+#define SKYPAT_FLAME_FRAME 16
+
+/* Define the margin around a flame graph, in pixels */
+#define SKYPAT_FLAME_MARGIN 10
+
+//===----------------------------------------------------------------------===//
+// Helper Functions
+//===----------------------------------------------------------------------===//
+namespace {
+
+/// A frame of a flame graph. Frames live in a vector and refer to their
+/// children by index.
+struct Frame
+{
+  std::string function;
+  uint64_t count;
+  unsigned int depth;
+  std::vector<unsigned int> children;
+};
+
+typedef std::vector<Frame> FrameList;
+
+/// Order the children of a frame by the name of their functions.
+class ByFunction
+{
+public:
+  explicit ByFunction(const FrameList& pFrames) : m_Frames(pFrames) { }
+
+  bool operator()(unsigned int pA, unsigned int pB) const {
+    return m_Frames[pA].function < m_Frames[pB].function;
+  }
+
+private:
+  const FrameList& m_Frames;
+};
+
+} // anonymous namespace
+
+/// Find the child pFunction of pParent, or add it.
+static unsigned int GetChild(FrameList& pFrames, unsigned int pParent,
+                             const std::string& pFunction)
+{
+  for (unsigned int i = 0; i < pFrames[pParent].children.size(); ++i) {
+    unsigned int child = pFrames[pParent].children[i];
+    if (pFrames[child].function == pFunction)
+      return child;
+  }
+
+  Frame frame;
+  frame.function = pFunction;
+  frame.count = 0;
+  frame.depth = pFrames[pParent].depth + 1;
+  pFrames.push_back(frame);
+  pFrames[pParent].children.push_back(pFrames.size() - 1);
+  return pFrames.size() - 1;
+}
+
+/// Merge the folded stacks into a tree. The first frame is the root.
+/// @return the depth of the deepest frame.
+static unsigned int BuildFrames(const testing::Profile& pProfile,
+                                FrameList& pFrames)
+{
+  Frame root;
+  root.function = "all";
+  root.count = 0;
+  root.depth = 0;
+  pFrames.push_back(root);
+
+  unsigned int max_depth = 0;
+  testing::Profile::StackMap::const_iterator stack,
+                                             sEnd = pProfile.stacks().end();
+  for (stack = pProfile.stacks().begin(); stack != sEnd; ++stack) {
+    unsigned int current = 0;
+    pFrames[current].count += stack->second;
+
+    std::string::size_type begin = 0;
+    while (begin <= stack->first.size()) {
+      std::string::size_type end = stack->first.find(';', begin);
+      if (std::string::npos == end)
+        end = stack->first.size();
+      current = GetChild(pFrames, current,
+                         stack->first.substr(begin, end - begin));
+      pFrames[current].count += stack->second;
+      begin = end + 1;
+    }
+    max_depth = std::max(max_depth, pFrames[current].depth);
+  }
+  return max_depth;
+}
+
+/// Escape the characters XML reserves.
+static std::string EscapeXML(const std::string& pText)
+{
+  std::string result;
+  for (unsigned int i = 0; i < pText.size(); ++i) {
+    switch (pText[i]) {
+      case '&':  result += "&amp;";  break;
+      case '<':  result += "&lt;";   break;
+      case '>':  result += "&gt;";   break;
+      case '"':  result += "&quot;"; break;
+      case '\'': result += "&apos;"; break;
+      default:   result += pText[i]; break;
+    }
+  }
+  return result;
+}
+
+/// Pick a warm color by the name of the function, so that a function keeps
+/// its color in every graph.
+static std::string FrameColor(const std::string& pFunction)
+{
+  unsigned int hash = 2166136261u;
+  for (unsigned int i = 0; i < pFunction.size(); ++i)
+    hash = (hash ^ static_cast<unsigned char>(pFunction[i])) * 16777619u;
+
+  std::ostringstream color;
+  color << "rgb(" << (205 + hash % 51) << ","
+        << (80 + (hash >> 8) % 151) << ","
+        << ((hash >> 16) % 56) << ")";
+  return color.str();
+}
+
+/// Draw pFrame and its children from the left edge pX. The root is at the
+/// bottom and the callees are stacked upon their callers.
+static void DrawFrame(std::ostream& pOS, const FrameList& pFrames,
+                      unsigned int pFrame, double pX, double pScale,
+                      uint64_t pTotal, unsigned int pBottom)
+{
+  const Frame& frame = pFrames[pFrame];
+  double width = frame.count * pScale;
+  if (width < 0.1)
+    return;
+
+  unsigned int y = pBottom - (frame.depth + 1) * SKYPAT_FLAME_FRAME;
+  std::string function = EscapeXML(frame.function);
+  pOS << "<g><title>" << function << " (" << frame.count << " samples, "
+      << (100.0 * frame.count / pTotal) << "%)</title>"
+      << "<rect x=\"" << pX << "\" y=\"" << y << "\" width=\"" << width
+      << "\" height=\"" << (SKYPAT_FLAME_FRAME - 1) << "\" fill=\""
+      << FrameColor(frame.function) << "\" rx=\"2\" ry=\"2\"/>";
+
+  // about 7 pixels a character at font-size 12
+  unsigned int fits = static_cast<unsigned int>((width - 6) / 7);
+  if (3 <= fits) {
+    std::string label = frame.function;
+    if (label.size() > fits)
+      label = label.substr(0, fits - 2) + "..";
+    pOS << "<text x=\"" << (pX + 3) << "\" y=\""
+        << (y + SKYPAT_FLAME_FRAME - 4) << "\">" << EscapeXML(label)
+        << "</text>";
+  }
+  pOS << "</g>\n";
+
+  std::vector<unsigned int> children(frame.children);
+  std::sort(children.begin(), children.end(), ByFunction(pFrames));
+  for (unsigned int i = 0; i < children.size(); ++i) {
+    DrawFrame(pOS, pFrames, children[i], pX, pScale, pTotal, pBottom);
+    pX += pFrames[children[i]].count * pScale;
+  }
+}
+
+/// The base name of the files of a region: its key, such as "Case.test.42"
+/// or "Case.test.decode". The arguments of a parameterized test and the
+/// nested regions are separated by '_' instead of '/'.
+static std::string FileName(const testing::TestInfo& pTestInfo,
+                            const testing::PerfPartResult& pResult)
+{
+  std::string result = pTestInfo.getKey(pResult);
+  std::replace(result.begin(), result.end(), '/', '_');
+  return result;
+}
+
+//===----------------------------------------------------------------------===//
+// FlameGraphPrinter
+//===----------------------------------------------------------------------===//
+FlameGraphPrinter::FlameGraphPrinter(const std::string& pDirectory)
+  : m_Directory(pDirectory) {
+}
+
+void FlameGraphPrinter::OnTestEnd(const testing::TestInfo& pTestInfo)
+{
+  testing::TestResult::Performance::const_iterator perf =
+                                    pTestInfo.result().performance().begin();
+  testing::TestResult::Performance::const_iterator pEnd =
+                                    pTestInfo.result().performance().end();
+  for (; perf != pEnd; ++perf) {
+    const testing::Profile& profile = (*perf)->getProfile();
+    if (profile.empty())
+      continue;
+
+    Path base(m_Directory);
+    base.append(Path(FileName(pTestInfo, **perf)));
+
+    std::string folded = base.native() + ".folded";
+    std::ofstream folded_file(folded.c_str());
+    if (!folded_file.good()) {
+      testing::Log::getOStream() << "Failed to open file `" << folded
+                                 << "`\n";
+      continue;
+    }
+    PrintFolded(folded_file, profile);
+
+    std::ostringstream title;
+    title << pTestInfo.getKey(**perf) << " (" << (*perf)->filename() << ":"
+          << (*perf)->lineNumber() << ")";
+
+    std::string svg = base.native() + ".svg";
+    std::ofstream svg_file(svg.c_str());
+    if (!svg_file.good()) {
+      testing::Log::getOStream() << "Failed to open file `" << svg << "`\n";
+      continue;
+    }
+    PrintSVG(svg_file, profile, title.str());
+  }
+}
+
+void FlameGraphPrinter::PrintFolded(std::ostream& pOS,
+                                    const testing::Profile& pProfile)
+{
+  testing::Profile::StackMap::const_iterator stack,
+                                             sEnd = pProfile.stacks().end();
+  for (stack = pProfile.stacks().begin(); stack != sEnd; ++stack)
+    pOS << stack->first << " " << stack->second << "\n";
+}
+
+void FlameGraphPrinter::PrintSVG(std::ostream& pOS,
+                                 const testing::Profile& pProfile,
+                                 const std::string& pTitle)
+{
+  FrameList frames;
+  unsigned int max_depth = BuildFrames(pProfile, frames);
+
+  // the title line, then a row for every level of frames
+  unsigned int top = 2 * SKYPAT_FLAME_MARGIN + SKYPAT_FLAME_FRAME;
+  unsigned int height = top + (max_depth + 1) * SKYPAT_FLAME_FRAME
+                        + SKYPAT_FLAME_MARGIN;
+  unsigned int bottom = height - SKYPAT_FLAME_MARGIN;
+  double scale = 0.0;
+  if (0 != frames.front().count)
+    scale = double(SKYPAT_FLAME_WIDTH - 2 * SKYPAT_FLAME_MARGIN) /
+            frames.front().count;
+
+  pOS << "<?xml version=\"1.0\" standalone=\"no\"?>\n"
+      << "<svg version=\"1.1\" xmlns=\"http://www.w3.org/2000/svg\" "
+      << "width=\"" << SKYPAT_FLAME_WIDTH << "\" height=\"" << height
+      << "\" viewBox=\"0 0 " << SKYPAT_FLAME_WIDTH << " " << height << "\" "
+      << "font-family=\"Verdana, sans-serif\" font-size=\"12\">\n"
+      << "<rect x=\"0\" y=\"0\" width=\"100%\" height=\"100%\" "
+      << "fill=\"rgb(248,248,248)\"/>\n"
+      << "<text x=\"" << (SKYPAT_FLAME_WIDTH / 2) << "\" y=\""
+      << (SKYPAT_FLAME_MARGIN + SKYPAT_FLAME_FRAME - 2)
+      << "\" text-anchor=\"middle\" font-size=\"15\">" << EscapeXML(pTitle)
+      << " - " << pProfile.samples() << " samples";
+  if (0 != pProfile.lost())
+    pOS << ", " << pProfile.lost() << " lost";
+  pOS << "</text>\n";
+
+  if (0 != frames.front().count)
+    DrawFrame(pOS, frames, 0, SKYPAT_FLAME_MARGIN, scale,
+              frames.front().count, bottom);
+  pOS << "</svg>\n";
+}
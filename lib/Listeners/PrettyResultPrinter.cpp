@@ -8,10 +8,282 @@
 //===----------------------------------------------------------------------===//
 #include <skypat/Listeners/PrettyResultPrinter.h>
 #include <skypat/ADT/Color.h>
+#include <skypat/Support/OStrStream.h>
+#include <skypat/Support/Perf.h>
+#include <skypat/Support/Scheduler.h>
+#include <skypat/Support/Timer.h>
+#include <algorithm>
 #include <iostream>
+#include <map>
 
 using namespace skypat;
 
+/* Define the number of hot functions reported by a sampled test */
+#define SKYPAT_PROFILE_TOP 10
+
+//===----------------------------------------------------------------------===//
+// Helper Functions
+//===----------------------------------------------------------------------===//
+/// Print a row of a summary of the timer samples of every PERFORM.
+static void PrintTimerStats(const char* pTag,
+                            const testing::TestResult::Performance& pPerfs,
+                            double (testing::Statistics::*pStat)() const)
+{
+  testing::Log::getOStream() << Color::Bold(Color::BLUE) << pTag
+                             << std::fixed << std::setprecision(1);
+
+  testing::TestResult::Performance::const_iterator perf, pEnd = pPerfs.end();
+  for (perf = pPerfs.begin(); perf != pEnd; ++perf) {
+    testing::Log::getOStream() << " " << std::setw(12)
+                               << ((*perf)->getTimerStats().*pStat)();
+  }
+
+  testing::Log::getOStream().unsetf(std::ios::floatfield);
+  testing::Log::getOStream() << std::setprecision(6)
+                             << Color::RESET << std::endl;
+}
+
+/// Print a row of a bound of the confidence interval of every PERFORM.
+/// Regions with too few samples for an interval print n/a.
+static void PrintInterval(const char* pTag,
+                          const testing::TestResult::Performance& pPerfs,
+                          double (testing::Statistics::*pBound)() const)
+{
+  testing::Log::getOStream() << Color::Bold(Color::BLUE) << pTag
+                             << std::fixed << std::setprecision(1);
+
+  testing::TestResult::Performance::const_iterator perf, pEnd = pPerfs.end();
+  for (perf = pPerfs.begin(); perf != pEnd; ++perf) {
+    const testing::Statistics& time = (*perf)->getTimerStats();
+    testing::Log::getOStream() << " " << std::setw(12);
+    if (time.hasInterval())
+      testing::Log::getOStream() << (time.*pBound)();
+    else
+      testing::Log::getOStream() << "n/a";
+  }
+
+  testing::Log::getOStream().unsetf(std::ios::floatfield);
+  testing::Log::getOStream() << std::setprecision(6)
+                             << Color::RESET << std::endl;
+}
+
+/// Print a row of a per-iteration number of every PERFORM.
+static void PrintResults(const char* pTag,
+                         const testing::TestResult::Performance& pPerfs,
+                         double (testing::PerfPartResult::*pNum)() const)
+{
+  testing::Log::getOStream() << Color::Bold(Color::BLUE) << pTag
+                             << std::fixed << std::setprecision(1);
+
+  testing::TestResult::Performance::const_iterator perf, pEnd = pPerfs.end();
+  for (perf = pPerfs.begin(); perf != pEnd; ++perf)
+    testing::Log::getOStream() << " " << std::setw(12) << ((*perf)->*pNum)();
+
+  testing::Log::getOStream().unsetf(std::ios::floatfield);
+  testing::Log::getOStream() << std::setprecision(6)
+                             << Color::RESET << std::endl;
+}
+
+/// Print a corrected time. A time whose overheads are at least the median
+/// is shown as such instead of as zero.
+static void PrintCorrectedTime(const testing::PerfPartResult& pResult)
+{
+  testing::Log::getOStream() << " " << std::setw(12);
+  if (pResult.isTimerBelowOverhead())
+    testing::Log::getOStream() << "< overhead";
+  else
+    testing::Log::getOStream() << pResult.getCorrectedTimerNum();
+}
+
+/// Print a row of a latency percentile of every PERFORM. Regions without
+/// latencies leave their cells blank.
+static void PrintLatency(const char* pTag,
+                         const testing::TestResult::Performance& pPerfs,
+                         double pPercentile)
+{
+  testing::Log::getOStream() << Color::Bold(Color::BLUE) << pTag;
+
+  testing::TestResult::Performance::const_iterator perf, pEnd = pPerfs.end();
+  for (perf = pPerfs.begin(); perf != pEnd; ++perf) {
+    const testing::Histogram& latency = (*perf)->getLatency();
+    if (latency.empty())
+      testing::Log::getOStream() << " " << std::setw(12) << "";
+    else if (100.0 <= pPercentile)
+      testing::Log::getOStream() << " " << std::setw(12) << latency.max();
+    else {
+      testing::Log::getOStream() << " " << std::setw(12)
+                                 << latency.percentile(pPercentile);
+    }
+  }
+  testing::Log::getOStream() << Color::RESET << std::endl;
+}
+
+/// Print a row of a scaling number of every PERFORM. Regions that don't run
+/// on worker threads leave their cells blank.
+static void PrintScaling(const char* pTag,
+                         const testing::TestResult::Performance& pPerfs,
+                         double (testing::PerfPartResult::*pNum)() const)
+{
+  testing::Log::getOStream() << Color::Bold(Color::BLUE) << pTag
+                             << std::fixed << std::setprecision(2);
+
+  testing::TestResult::Performance::const_iterator perf, pEnd = pPerfs.end();
+  for (perf = pPerfs.begin(); perf != pEnd; ++perf) {
+    if ((*perf)->getThreadResults().empty())
+      testing::Log::getOStream() << " " << std::setw(12) << "";
+    else
+      testing::Log::getOStream() << " " << std::setw(12) << ((*perf)->*pNum)();
+  }
+
+  testing::Log::getOStream().unsetf(std::ios::floatfield);
+  testing::Log::getOStream() << std::setprecision(6)
+                             << Color::RESET << std::endl;
+}
+
+/// Print a row of a throughput rate of every PERFORM. Regions that declare
+/// no such work leave their cells blank.
+static void PrintRates(const char* pTag,
+                       const testing::TestResult::Performance& pPerfs,
+                       uint64_t (testing::Throughput::*pWork)() const,
+                       double (testing::PerfPartResult::*pRate)() const,
+                       double pScale, int pPrecision)
+{
+  testing::Log::getOStream() << Color::Bold(Color::BLUE) << pTag
+                             << std::fixed << std::setprecision(pPrecision);
+
+  testing::TestResult::Performance::const_iterator perf, pEnd = pPerfs.end();
+  for (perf = pPerfs.begin(); perf != pEnd; ++perf) {
+    if (0 == ((*perf)->getThroughput().*pWork)())
+      testing::Log::getOStream() << " " << std::setw(12) << "";
+    else {
+      testing::Log::getOStream() << " " << std::setw(12)
+                                 << ((*perf)->*pRate)() * pScale;
+    }
+  }
+
+  testing::Log::getOStream().unsetf(std::ios::floatfield);
+  testing::Log::getOStream() << std::setprecision(6)
+                             << Color::RESET << std::endl;
+}
+
+/// Print the hottest functions of a profile, by their self samples.
+static void PrintProfile(const testing::Profile& pProfile)
+{
+  testing::Log::getOStream() << Color::Bold(Color::BLUE) << "[ PROFILE  ] "
+                             << Color::RESET << pProfile.samples()
+                             << " samples";
+  if (0 != pProfile.lost())
+    testing::Log::getOStream() << ", " << pProfile.lost() << " lost";
+  testing::Log::getOStream() << "; self% total% function" << std::endl;
+
+  testing::Profile::EntryList hot = pProfile.top(SKYPAT_PROFILE_TOP);
+  testing::Log::getOStream() << std::fixed << std::setprecision(1);
+  for (unsigned int i = 0; i < hot.size(); ++i) {
+    testing::Log::getOStream() << Color::Bold(Color::BLUE) << "[ HOT "
+                               << std::setw(4) << (i + 1) << " ]"
+                               << Color::RESET << " " << std::setw(6)
+                               << 100.0 * hot[i].self / pProfile.samples()
+                               << " " << std::setw(6)
+                               << 100.0 * hot[i].total / pProfile.samples()
+                               << " " << hot[i].function << std::endl;
+  }
+  testing::Log::getOStream().unsetf(std::ios::floatfield);
+  testing::Log::getOStream() << std::setprecision(6);
+}
+
+/// Print a nested region and the regions nested in it, indented by their
+/// depths. The share is of the time of the outermost region.
+static void PrintRegion(const testing::TestInfo& pTestInfo,
+                        const testing::PerfPartResult& pResult,
+                        double pRootTime)
+{
+  double time = pResult.getTimerStats().median();
+  testing::Log::getOStream() << Color::Bold(Color::BLUE) << "[  REGION  ] "
+                             << Color::RESET
+                             << std::string(2 * pResult.getDepth(), ' ')
+                             << pTestInfo.getKey(pResult) << ": "
+                             << std::fixed << std::setprecision(1) << time
+                             << " ns inclusive, "
+                             << pResult.getExclusiveTimerStats().median()
+                             << " ns exclusive";
+  if (0.0 < pRootTime)
+    testing::Log::getOStream() << ", " << (100.0 * time / pRootTime) << "%";
+  testing::Log::getOStream().unsetf(std::ios::floatfield);
+  testing::Log::getOStream() << std::setprecision(6) << std::endl;
+
+  for (unsigned int i = 0; i < pResult.getChildren().size(); ++i)
+    PrintRegion(pTestInfo, *pResult.getChildren()[i], pRootTime);
+}
+
+/// Print the phases between the laps of a region. The share is of the time
+/// of the region.
+static void PrintLaps(const testing::TestInfo& pTestInfo,
+                      const testing::PerfPartResult& pResult)
+{
+  double total = pResult.getTimerStats().median();
+  testing::Log::getOStream() << std::fixed << std::setprecision(1);
+  for (unsigned int lap = 0; lap < pResult.getNumOfLaps(); ++lap) {
+    double time = pResult.getLapTimerStats(lap).median();
+    testing::Log::getOStream() << Color::Bold(Color::BLUE) << "[   LAP    ] "
+                               << Color::RESET << pTestInfo.getKey(pResult)
+                               << " "
+                               << pResult.getLapName(lap) << ": " << time
+                               << " ns";
+    if (0.0 < total)
+      testing::Log::getOStream() << ", " << (100.0 * time / total) << "%";
+    for (unsigned int idx = 0; idx < pResult.getNumOfPerfEvents(); ++idx) {
+      std::string name =
+          testing::internal::Perf::name(pResult.getPerfEventType(idx));
+      testing::Log::getOStream() << ", " << name << " "
+          << pResult.getLapPerfEventStats(lap, idx).median();
+    }
+    testing::Log::getOStream() << std::endl;
+  }
+  testing::Log::getOStream().unsetf(std::ios::floatfield);
+  testing::Log::getOStream() << std::setprecision(6);
+}
+
+/// Probe the predefined events and the events of the run, and print which
+/// ones perf_event counts, which ones fall back to the system, and which
+/// ones are left out.
+static void PrintPreflight(const testing::RunOptions& pOptions)
+{
+  std::vector<enum PerfEvent> events;
+  for (int event = PerfEvent::CPU_CYCLES;
+       event <= PerfEvent::EMULATION_FAULTS; ++event)
+    events.push_back(static_cast<enum PerfEvent>(event));
+  for (unsigned int i = 0; i < pOptions.getEvents().size(); ++i)
+    events.push_back(pOptions.getEvents()[i]);
+
+  // backend -> the names of its events, in the order of the backends found
+  std::vector<std::string> backends;
+  std::map<std::string, std::string> names;
+  for (unsigned int i = 0; i < events.size(); ++i) {
+    std::string backend = testing::internal::Perf::probe(events[i]);
+    std::string& list = names[backend];
+    if (list.empty())
+      backends.push_back(backend);
+    else
+      list += ", ";
+    list += testing::internal::Perf::name(events[i]);
+  }
+
+  testing::Log::getOStream() << Color::CYAN << "[PREFLIGHT ] timer "
+                             << testing::internal::Timer::backend();
+  int paranoid;
+  if (testing::internal::Perf::paranoid(paranoid))
+    testing::Log::getOStream() << ", perf_event_paranoid " << paranoid;
+  testing::Log::getOStream() << std::endl;
+
+  for (unsigned int i = 0; i < backends.size(); ++i) {
+    testing::Log::getOStream() << (("none" == backends[i]) ? Color::YELLOW
+                                                           : Color::CYAN)
+                               << "[PREFLIGHT ] " << backends[i] << ": "
+                               << names[backends[i]] << Color::RESET
+                               << std::endl;
+  }
+}
+
 //===----------------------------------------------------------------------===//
 // PrettyResultPrinter
 //===----------------------------------------------------------------------===//
@@ -26,6 +298,18 @@ void PrettyResultPrinter::OnTestProgramStart(const testing::UnitTest& pUnitTest)
   testing::Log::getOStream() << Color::CYAN << "[  skypat  ] "
     << "Running " << pUnitTest.getNumOfTests()
     << " tests from " << pUnitTest.getNumOfCases() << " cases." << std::endl;
+
+  const testing::RunOptions& options = pUnitTest.options();
+  if (!options.getCPUs().empty()) {
+    testing::Log::getOStream() << "[  skypat  ] Pinned to CPUs "
+      << testing::internal::Scheduler::toString(options.getCPUs())
+      << std::endl;
+  }
+  if (0 < options.getRealTimePriority()) {
+    testing::Log::getOStream() << "[  skypat  ] Scheduled by SCHED_FIFO at "
+      << "priority " << options.getRealTimePriority() << std::endl;
+  }
+  PrintPreflight(options);
 }
 
 void PrettyResultPrinter::OnTestCaseStart(const testing::TestCase& pTestCase)
@@ -97,52 +381,457 @@ void PrettyResultPrinter::OnTestEnd(const testing::TestInfo& pTestInfo)
     testing::Log::getOStream() << std::endl;
   }
 
-  // performance test results
-  if (!pTestInfo.result().performance().empty()) {
+  // performance test results. The results of single worker threads are
+  // shown within the result that sums them up.
+  testing::TestResult::Performance perfs;
+  testing::TestResult::Performance::const_iterator perf, pEnd;
+  pEnd = pTestInfo.result().performance().end();
+  for (perf = pTestInfo.result().performance().begin(); perf != pEnd; ++perf) {
+    if (-1 == (*perf)->getThreadIndex())
+      perfs.push_back(*perf);
+  }
+
+  if (!perfs.empty()) {
+    // the key of every column in full; the messages below the table name
+    // the regions by their keys, too
+    pEnd = perfs.end();
+    unsigned int column = 1;
+    for (perf = perfs.begin(); perf != pEnd; ++perf, ++column) {
+      testing::Log::getOStream() << Color::Bold(Color::BLUE)
+                                 << "[   KEY    ] " << Color::RESET << column
+                                 << ": " << pTestInfo.getKey(**perf)
+                                 << std::endl;
+    }
+
+    // the regions of the columns. A region longer than the column is named
+    // by the number of its key, so that no two columns look the same.
+    testing::Log::getOStream() << Color::Bold(Color::BLUE) << "[   NAME   ]";
+    column = 1;
+    for (perf = perfs.begin(); perf != pEnd; ++perf, ++column) {
+      std::string region = pTestInfo.getRegion(**perf);
+      if (12 < region.size()) {
+        region.clear();
+        OStrStream OS(region);
+        OS << "key " << column;
+      }
+      testing::Log::getOStream() << " " << std::setw(12) << region;
+    }
+    testing::Log::getOStream() << Color::RESET << std::endl;
+
     // timer's result
     testing::Log::getOStream() << Color::Bold(Color::BLUE)
                                << "[ TIME (ns)]";
 
-    testing::TestResult::Performance::const_iterator perf =
-                                      pTestInfo.result().performance().begin();
-    testing::TestResult::Performance::const_iterator pEnd =
-                                      pTestInfo.result().performance().end();
-
-    while (perf != pEnd) {
+    for (perf = perfs.begin(); perf != pEnd; ++perf) {
       testing::Log::getOStream() << " " << std::setw(12)
                                  << (*perf)->getTimerNum();
-      ++perf;
     }
     testing::Log::getOStream() << Color::RESET << std::endl;
 
-    // perf_event's types
-    testing::Log::getOStream() << Color::Bold(Color::BLUE)
-                               << "[EVENT TYPE]";
+    // the overhead of an empty region, and the time without it
+    PrintResults("[ OVERHEAD ]", perfs,
+                 &testing::PerfPartResult::getTimerOverhead);
+    testing::Log::getOStream() << Color::Bold(Color::BLUE) << "[ CORRECTED]"
+                               << std::fixed << std::setprecision(1);
+    for (perf = perfs.begin(); perf != pEnd; ++perf)
+      PrintCorrectedTime(**perf);
+    testing::Log::getOStream().unsetf(std::ios::floatfield);
+    testing::Log::getOStream() << std::setprecision(6)
+                               << Color::RESET << std::endl;
 
-    perf = pTestInfo.result().performance().begin();
-    pEnd = pTestInfo.result().performance().end();
+    // the time without the nested regions
+    bool has_nested = false;
+    for (perf = perfs.begin(); perf != pEnd; ++perf)
+      has_nested = has_nested || (*perf)->hasChildren();
 
-    while (perf != pEnd) {
-      testing::Log::getOStream() << " [" << std::setw(10)
-                                 << skypat::Perf_event_name[(*perf)->getPerfEventType()]
-                                 << "]";
-      ++perf;
+    if (has_nested) {
+      testing::Log::getOStream() << Color::Bold(Color::BLUE)
+                                 << "[EXCLUSIVE ]"
+                                 << std::fixed << std::setprecision(1);
+      for (perf = perfs.begin(); perf != pEnd; ++perf) {
+        testing::Log::getOStream() << " " << std::setw(12)
+            << (*perf)->getExclusiveTimerStats().median();
+      }
+      testing::Log::getOStream().unsetf(std::ios::floatfield);
+      testing::Log::getOStream() << std::setprecision(6)
+                                 << Color::RESET << std::endl;
+    }
+
+    // summaries of the timer's samples
+    if (1 < perfs.front()->getTimerStats().size()) {
+      PrintTimerStats("[   MEAN   ]", perfs, &testing::Statistics::mean);
+      PrintTimerStats("[  STDDEV  ]", perfs, &testing::Statistics::stddev);
+      PrintTimerStats("[   MAD    ]", perfs, &testing::Statistics::mad);
+      PrintTimerStats("[   MIN    ]", perfs, &testing::Statistics::min);
+      PrintTimerStats("[   MAX    ]", perfs, &testing::Statistics::max);
+      PrintInterval("[ CI95 LOW ]", perfs, &testing::Statistics::lowerBound);
+      PrintInterval("[ CI95 HIGH]", perfs, &testing::Statistics::upperBound);
+
+      testing::Log::getOStream() << Color::Bold(Color::BLUE)
+                                 << "[ OUTLIERS ]";
+      for (perf = perfs.begin(); perf != pEnd; ++perf) {
+        testing::Log::getOStream() << " " << std::setw(12)
+                                   << (*perf)->getTimerStats().outliers();
+      }
+      testing::Log::getOStream() << Color::RESET << std::endl;
     }
-    testing::Log::getOStream() << Color::RESET << std::endl;
 
-    // perf_event's results
+    // the number of iterations of every sample
     testing::Log::getOStream() << Color::Bold(Color::BLUE)
-                               << "[RESULT NUM]";
+                               << "[ITERATIONS]";
+
+    for (perf = perfs.begin(); perf != pEnd; ++perf) {
+      testing::Log::getOStream() << " " << std::setw(12)
+                                 << (*perf)->getIterations();
+    }
+    testing::Log::getOStream() << Color::RESET << std::endl;
+
+    // the warmup, and the cost of the cold call apart from the samples
+    if (0 != perfs.front()->getWarmupIterations()) {
+      testing::Log::getOStream() << Color::Bold(Color::BLUE)
+                                 << "[FIRST CALL]";
+      for (perf = perfs.begin(); perf != pEnd; ++perf) {
+        testing::Log::getOStream() << " " << std::setw(12)
+                                   << (*perf)->getFirstCallTime();
+      }
+      testing::Log::getOStream() << Color::RESET << std::endl;
+
+      testing::Log::getOStream() << Color::Bold(Color::BLUE)
+                                 << "[  WARMUP  ]";
+      for (perf = perfs.begin(); perf != pEnd; ++perf) {
+        testing::Log::getOStream() << " " << std::setw(12)
+                                   << (*perf)->getWarmupTime();
+      }
+      testing::Log::getOStream() << Color::RESET << std::endl;
+    }
+
+    // the percentiles of the latencies of single iterations
+    bool has_latency = false;
+    for (perf = perfs.begin(); perf != pEnd; ++perf)
+      has_latency = has_latency || !(*perf)->getLatency().empty();
+
+    if (has_latency) {
+      PrintLatency("[ LAT  P50 ]", perfs, 50.0);
+      PrintLatency("[ LAT  P90 ]", perfs, 90.0);
+      PrintLatency("[ LAT  P99 ]", perfs, 99.0);
+      PrintLatency("[ LAT P999 ]", perfs, 99.9);
+      PrintLatency("[ LAT  MAX ]", perfs, 100.0);
+    }
+
+    // the declared work per second, and per cycle if cycles are counted
+    bool has_bytes = false, has_items = false, has_cycles = false;
+    for (perf = perfs.begin(); perf != pEnd; ++perf) {
+      has_bytes = has_bytes || (0 != (*perf)->getThroughput().bytes());
+      has_items = has_items || (0 != (*perf)->getThroughput().items());
+      for (unsigned int idx = 0; idx < (*perf)->getNumOfPerfEvents(); ++idx)
+        has_cycles = has_cycles ||
+                     (skypat::CPU_CYCLES == (*perf)->getPerfEventType(idx));
+    }
+
+    if (has_bytes) {
+      PrintRates("[   MB/S   ]", perfs, &testing::Throughput::bytes,
+                 &testing::PerfPartResult::getBytesPerSecond, 1e-6, 1);
+      if (has_cycles)
+        PrintRates("[ BYTES/CYC]", perfs, &testing::Throughput::bytes,
+                   &testing::PerfPartResult::getBytesPerCycle, 1.0, 3);
+    }
+    if (has_items) {
+      PrintRates("[ ITEMS/S  ]", perfs, &testing::Throughput::items,
+                 &testing::PerfPartResult::getItemsPerSecond, 1.0, 1);
+      if (has_cycles)
+        PrintRates("[ ITEMS/CYC]", perfs, &testing::Throughput::items,
+                   &testing::PerfPartResult::getItemsPerCycle, 1.0, 3);
+    }
 
-    perf = pTestInfo.result().performance().begin();
-    pEnd = pTestInfo.result().performance().end();
+    // the threads that ran a region together, the sum of their iterations
+    // per second, and the time of every thread
+    unsigned int max_threads = 0;
+    for (perf = perfs.begin(); perf != pEnd; ++perf)
+      max_threads = std::max(max_threads,
+                             (unsigned int)(*perf)->getThreadResults().size());
 
-    while (perf != pEnd) {
+    if (0 != max_threads) {
+      testing::Log::getOStream() << Color::Bold(Color::BLUE)
+                                 << "[ THREADS  ]";
+      for (perf = perfs.begin(); perf != pEnd; ++perf) {
+        testing::Log::getOStream() << " " << std::setw(12)
+                                   << (*perf)->getNumOfThreads();
+      }
+      testing::Log::getOStream() << Color::RESET << std::endl;
+
+      PrintResults("[  ITER/S  ]", perfs,
+                   &testing::PerfPartResult::getIterationsPerSecond);
+      PrintScaling("[ SPEEDUP  ]", perfs, &testing::PerfPartResult::getSpeedup);
+      PrintScaling("[EFFICIENCY]", perfs,
+                   &testing::PerfPartResult::getEfficiency);
+
+      for (unsigned int idx = 0; idx < max_threads; ++idx) {
+        testing::Log::getOStream() << Color::Bold(Color::BLUE)
+                                   << "[ THREAD" << std::setw(3) << idx << "]"
+                                   << std::fixed << std::setprecision(1);
+        for (perf = perfs.begin(); perf != pEnd; ++perf) {
+          const testing::TestResult::Performance& threads =
+                                                   (*perf)->getThreadResults();
+          if (idx < threads.size())
+            PrintCorrectedTime(*threads[idx]);
+          else
+            testing::Log::getOStream() << " " << std::setw(12) << "";
+        }
+        testing::Log::getOStream().unsetf(std::ios::floatfield);
+        testing::Log::getOStream() << std::setprecision(6)
+                                   << Color::RESET << std::endl;
+      }
+
+      // the Universal Scalability Law of every sweep
+      for (perf = perfs.begin(); perf != pEnd; ++perf) {
+        const testing::Scalability& usl = (*perf)->getScalability();
+        if (1 != (*perf)->getThreadResults().size() || !usl.isFitted())
+          continue;
+        testing::Log::getOStream() << Color::Bold(Color::BLUE)
+                                   << "[   USL    ] " << Color::RESET
+                                   << pTestInfo.getKey(**perf)
+                                   << ": sigma " << usl.sigma()
+                                   << ", kappa " << usl.kappa();
+        if (usl.isSaturated())
+          testing::Log::getOStream() << ", saturated";
+        else if (0.0 < usl.peak()) {
+          testing::Log::getOStream() << ", peak at " << std::fixed
+                                     << std::setprecision(1) << usl.peak()
+                                     << " threads";
+          testing::Log::getOStream().unsetf(std::ios::floatfield);
+          testing::Log::getOStream() << std::setprecision(6);
+        }
+        else
+          testing::Log::getOStream() << ", no peak";
+        testing::Log::getOStream() << std::endl;
+      }
+    }
+
+    // the cores the regions were seen on
+    testing::Log::getOStream() << Color::Bold(Color::BLUE)
+                               << "[   CPUS   ]";
+    for (perf = perfs.begin(); perf != pEnd; ++perf) {
       testing::Log::getOStream() << " " << std::setw(12)
-                                 << (*perf)->getPerfEventNum();
-      ++perf;
+          << testing::internal::Scheduler::toString((*perf)->getCPUs());
     }
     testing::Log::getOStream() << Color::RESET << std::endl;
+
+    // the path the counters were read by
+    testing::Log::getOStream() << Color::Bold(Color::BLUE)
+                               << "[READ  PATH]";
+    for (perf = perfs.begin(); perf != pEnd; ++perf) {
+      testing::Log::getOStream() << " " << std::setw(12)
+                                 << (*perf)->getReadPath();
+    }
+    testing::Log::getOStream() << Color::RESET << std::endl;
+
+    // what counted the regions, if perf_event could not count them all
+    bool has_fallback = false;
+    for (perf = perfs.begin(); perf != pEnd; ++perf)
+      has_fallback = has_fallback || ("perf" != (*perf)->getBackend());
+
+    if (has_fallback) {
+      testing::Log::getOStream() << Color::Bold(Color::YELLOW)
+                                 << "[ BACKEND  ]";
+      for (perf = perfs.begin(); perf != pEnd; ++perf) {
+        testing::Log::getOStream() << " " << std::setw(12)
+                                   << (*perf)->getBackend();
+      }
+      testing::Log::getOStream() << Color::RESET << std::endl;
+    }
+
+    // the part of the time multiplexed groups were counting; their event
+    // numbers are scaled estimates
+    bool has_multiplexed = false;
+    for (perf = perfs.begin(); perf != pEnd; ++perf)
+      has_multiplexed = has_multiplexed || (*perf)->isMultiplexed();
+
+    if (has_multiplexed) {
+      testing::Log::getOStream() << Color::Bold(Color::RED) << "[MULTIPLEX ]"
+                                 << std::fixed << std::setprecision(1);
+      for (perf = perfs.begin(); perf != pEnd; ++perf) {
+        if ((*perf)->isMultiplexed()) {
+          testing::Log::getOStream() << " " << std::setw(11)
+                                     << (*perf)->getRunningRatio() * 100.0
+                                     << "%";
+        }
+        else
+          testing::Log::getOStream() << " " << std::setw(12) << "";
+      }
+      testing::Log::getOStream().unsetf(std::ios::floatfield);
+      testing::Log::getOStream() << std::setprecision(6)
+                                 << Color::RESET << std::endl;
+    }
+
+    // perf_event's types and results. A region counts a group of events,
+    // one pair of rows per member of the groups.
+    unsigned int num_events = 0;
+    for (perf = perfs.begin(); perf != pEnd; ++perf)
+      num_events = std::max(num_events, (*perf)->getNumOfPerfEvents());
+
+    for (unsigned int idx = 0; idx < num_events; ++idx) {
+      testing::Log::getOStream() << Color::Bold(Color::BLUE)
+                                 << "[EVENT TYPE]";
+
+      for (perf = perfs.begin(); perf != pEnd; ++perf) {
+        if (idx < (*perf)->getNumOfPerfEvents()) {
+          // names of raw events are cut to the column; CSV keeps them
+          std::string name =
+              testing::internal::Perf::name((*perf)->getPerfEventType(idx));
+          if (10 < name.size())
+            name = name.substr(0, 9) + "~";
+          testing::Log::getOStream() << " [" << std::setw(10) << name << "]";
+        }
+        else
+          testing::Log::getOStream() << " " << std::setw(12) << "";
+      }
+      testing::Log::getOStream() << Color::RESET << std::endl;
+
+      testing::Log::getOStream() << Color::Bold(Color::BLUE)
+                                 << "[RESULT NUM]";
+
+      for (perf = perfs.begin(); perf != pEnd; ++perf) {
+        if (idx < (*perf)->getNumOfPerfEvents()) {
+          testing::Log::getOStream() << " " << std::setw(12)
+                                     << (*perf)->getPerfEventNum(idx);
+        }
+        else
+          testing::Log::getOStream() << " " << std::setw(12) << "";
+      }
+      testing::Log::getOStream() << Color::RESET << std::endl;
+
+      testing::Log::getOStream() << Color::Bold(Color::BLUE)
+                                 << "[ CORRECTED]"
+                                 << std::fixed << std::setprecision(1);
+
+      // blank unless the overhead of the event is known
+      for (perf = perfs.begin(); perf != pEnd; ++perf) {
+        if (idx < (*perf)->getNumOfPerfEvents() &&
+            (*perf)->isPerfEventBelowOverhead(idx)) {
+          testing::Log::getOStream() << " " << std::setw(12) << "< overhead";
+        }
+        else if (idx < (*perf)->getNumOfPerfEvents() &&
+                 (*perf)->isPerfEventCalibrated(idx)) {
+          testing::Log::getOStream() << " " << std::setw(12)
+                                     << (*perf)->getCorrectedPerfEventNum(idx);
+        }
+        else
+          testing::Log::getOStream() << " " << std::setw(12) << "";
+      }
+      testing::Log::getOStream().unsetf(std::ios::floatfield);
+      testing::Log::getOStream() << std::setprecision(6)
+                                 << Color::RESET << std::endl;
+
+      if (!has_nested)
+        continue;
+
+      testing::Log::getOStream() << Color::Bold(Color::BLUE)
+                                 << "[ EXCL NUM ]"
+                                 << std::fixed << std::setprecision(1);
+
+      for (perf = perfs.begin(); perf != pEnd; ++perf) {
+        if (idx < (*perf)->getNumOfPerfEvents()) {
+          testing::Log::getOStream() << " " << std::setw(12)
+              << (*perf)->getExclusivePerfEventStats(idx).median();
+        }
+        else
+          testing::Log::getOStream() << " " << std::setw(12) << "";
+      }
+      testing::Log::getOStream().unsetf(std::ios::floatfield);
+      testing::Log::getOStream() << std::setprecision(6)
+                                 << Color::RESET << std::endl;
+    }
+
+    // the tree of every region with nested ones
+    for (perf = perfs.begin(); perf != pEnd; ++perf) {
+      if (NULL == (*perf)->getParent() && (*perf)->hasChildren())
+        PrintRegion(pTestInfo, **perf, (*perf)->getTimerStats().median());
+    }
+
+    // the phases between the laps of every region
+    for (perf = perfs.begin(); perf != pEnd; ++perf)
+      PrintLaps(pTestInfo, **perf);
+
+    // the hot functions of all sampled regions of the test
+    testing::Profile profile;
+    for (perf = perfs.begin(); perf != pEnd; ++perf)
+      profile.merge((*perf)->getProfile());
+
+    if (!profile.empty())
+      PrintProfile(profile);
+  }
+}
+
+void PrettyResultPrinter::OnTestCaseEnd(const testing::TestCase& pTestCase)
+{
+  // gather the instances of every parameterized test. An instance is named
+  // by its test followed by its arguments, such as "test/8/64".
+  typedef std::vector<const testing::TestInfo*> Instances;
+  std::vector<std::string> names;
+  std::map<std::string, Instances> families;
+
+  testing::TestCase::const_iterator info, iEnd = pTestCase.end();
+  for (info = pTestCase.begin(); info != iEnd; ++info) {
+    if ((*info)->args().empty())
+      continue;
+    const std::string& test_name = (*info)->getTestName();
+    std::string name = test_name.substr(0, test_name.find('/'));
+    if (families.end() == families.find(name))
+      names.push_back(name);
+    families[name].push_back(*info);
+  }
+
+  // fit the corrected time of every PERFORM to the first argument. The
+  // PERFORMs of the instances are matched by their regions.
+  std::vector<std::string>::const_iterator name, nEnd = names.end();
+  for (name = names.begin(); name != nEnd; ++name) {
+    const Instances& instances = families[*name];
+    if (2 > instances.size())
+      continue;
+
+    const testing::TestResult::Performance& first =
+                                     instances.front()->result().performance();
+    for (unsigned int idx = 0; idx < first.size(); ++idx) {
+      if (-1 != first[idx]->getThreadIndex())
+        continue;
+
+      std::string region = instances.front()->getRegion(*first[idx]);
+      std::vector<double> sizes, costs;
+      Instances::const_iterator inst, instEnd = instances.end();
+      for (inst = instances.begin(); inst != instEnd; ++inst) {
+        const testing::TestResult::Performance& perfs =
+                                                 (*inst)->result().performance();
+        testing::TestResult::Performance::const_iterator perf, pEnd;
+        pEnd = perfs.end();
+        for (perf = perfs.begin(); perf != pEnd; ++perf) {
+          if (-1 == (*perf)->getThreadIndex() &&
+              region == (*inst)->getRegion(**perf))
+            break;
+        }
+        if (pEnd == perf || (*perf)->isTimerBelowOverhead())
+          continue;
+        sizes.push_back((*inst)->args().front());
+        costs.push_back((*perf)->getCorrectedTimerNum());
+      }
+
+      testing::Complexity complexity;
+      complexity.fit(sizes, costs);
+
+      testing::Log::getOStream() << Color::Bold(Color::BLUE)
+                                 << "[COMPLEXITY] " << Color::WHITE;
+      // the key of the region in every instance, less the arguments
+      PrintCaseName(pTestCase.getCaseName(), *name);
+      testing::Log::getOStream()
+          << "." << region << ": "
+          << Color::RESET
+          << testing::Complexity::name(complexity.bigO())
+          << std::fixed << std::setprecision(3)
+          << ", coefficient " << complexity.coefficient()
+          << std::setprecision(1)
+          << ", rms " << (complexity.rms() * 100.0) << "%"
+          << std::setprecision(6) << std::endl;
+      testing::Log::getOStream().unsetf(std::ios::floatfield);
+    }
   }
 }
 
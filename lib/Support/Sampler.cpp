@@ -0,0 +1,50 @@
+//===- Sampler.cpp --------------------------------------------------------===//
+//
+//                     The SkyPat Team
+//
+// This file is distributed under the New BSD License. 
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#include <skypat/Support/Sampler.h>
+#include <skypat/Support/Symbolizer.h>
+#include <skypat/Config/Config.h>
+
+using namespace skypat;
+using namespace skypat::testing::internal;
+
+//===----------------------------------------------------------------------===//
+// Sampler
+//===----------------------------------------------------------------------===//
+testing::Profile Sampler::profile() const
+{
+  testing::Profile result;
+  result.addLost(m_Lost);
+
+  Symbolizer& symbolizer = Symbolizer::self();
+  std::vector<std::string> chain;
+  unsigned int idx = 0;
+  while (idx < m_Chains.size()) {
+    uint64_t length = m_Chains[idx++];
+    chain.clear();
+    for (uint64_t i = 0; i < length && idx < m_Chains.size(); ++i, ++idx)
+      chain.push_back(symbolizer.symbolize(m_Chains[idx], 0 != i));
+    result.addSample(chain);
+  }
+  return result;
+}
+
+//===----------------------------------------------------------------------===//
+// Sampler Implementation
+//===----------------------------------------------------------------------===//
+#if defined(SKYPAT_ON_WIN32)
+#include "Windows/Sampler.inc"
+#endif
+
+#if defined(SKYPAT_ON_UNIX)
+#include "Unix/Sampler.inc"
+#endif
+
+#if defined(SKYPAT_ON_DRAGON)
+#include "Dragon/Sampler.inc"
+#endif
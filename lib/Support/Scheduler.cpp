@@ -0,0 +1,81 @@
+//===- Scheduler.cpp ------------------------------------------------------===//
+//
+//                     The SkyPat Team
+//
+// This file is distributed under the New BSD License. 
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#include <skypat/Support/Scheduler.h>
+#include <skypat/Support/OStrStream.h>
+#include <skypat/Config/Config.h>
+#include <cstdlib>
+
+using namespace skypat;
+using namespace skypat::testing::internal;
+
+//===----------------------------------------------------------------------===//
+// Scheduler
+//===----------------------------------------------------------------------===//
+bool Scheduler::parse(const std::string& pList, CPUList& pCPUs)
+{
+  pCPUs.clear();
+  const char* cur = pList.c_str();
+  while ('\0' != *cur) {
+    char* end;
+    long first = strtol(cur, &end, 10);
+    if (end == cur || 0 > first)
+      return false;
+    long last = first;
+    cur = end;
+    if ('-' == *cur) {
+      last = strtol(cur + 1, &end, 10);
+      if (end == cur + 1 || last < first)
+        return false;
+      cur = end;
+    }
+    for (long cpu = first; cpu <= last; ++cpu)
+      pCPUs.push_back(cpu);
+
+    if (',' == *cur)
+      ++cur;
+    else if ('\0' != *cur)
+      return false;
+  }
+  return !pCPUs.empty();
+}
+
+std::string Scheduler::toString(const CPUList& pCPUs)
+{
+  std::string result;
+  OStrStream OS(result);
+  unsigned int i = 0;
+  while (i < pCPUs.size()) {
+    // a run of consecutive CPUs is a range
+    unsigned int j = i;
+    while (j + 1 < pCPUs.size() && pCPUs[j + 1] == pCPUs[j] + 1)
+      ++j;
+    if (0 != i)
+      OS << ",";
+    OS << pCPUs[i];
+    if (j != i)
+      OS << "-" << pCPUs[j];
+    i = j + 1;
+  }
+  return result;
+}
+
+//===----------------------------------------------------------------------===//
+// Scheduler Implementation
+//===----------------------------------------------------------------------===//
+#if defined(SKYPAT_ON_WIN32)
+#include "Windows/Scheduler.inc"
+#endif
+
+#if defined(SKYPAT_ON_UNIX)
+#include "Unix/Scheduler.inc"
+#endif
+
+#if defined(SKYPAT_ON_DRAGON)
+#include "Dragon/Scheduler.inc"
+#endif
@@ -0,0 +1,102 @@
+//===- Symbolizer.cpp -----------------------------------------------------===//
+//
+//                     The SkyPat Team
+//
+// This file is distributed under the New BSD License. 
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#include <skypat/Support/Symbolizer.h>
+#include <skypat/Support/Path.h>
+#include <skypat/Config/Config.h>
+#include <algorithm>
+
+using namespace skypat;
+using namespace skypat::testing::internal;
+
+//===----------------------------------------------------------------------===//
+// Symbolizer
+//===----------------------------------------------------------------------===//
+Symbolizer::Symbolizer()
+  : m_Mappings(), m_Modules(), m_Mutex() {
+}
+
+Symbolizer& Symbolizer::self()
+{
+  static Symbolizer symbolizer;
+  return symbolizer;
+}
+
+std::string Symbolizer::symbolize(uint64_t pAddress, bool pIsReturnAddress)
+{
+  ScopedLock lock(m_Mutex);
+  if (pIsReturnAddress)
+    --pAddress;
+
+  const Mapping* mapping = findMapping(pAddress);
+  if (NULL == mapping)
+    return "[unknown]";
+
+  // the address in the file, and then in the address space of the file
+  const Module& mod = module(mapping->path);
+  uint64_t offset = pAddress - mapping->start + mapping->offset;
+  std::vector<Segment>::const_iterator seg, sEnd = mod.segments.end();
+  for (seg = mod.segments.begin(); seg != sEnd; ++seg) {
+    if (seg->offset <= offset && offset < seg->offset + seg->size)
+      break;
+  }
+
+  if (sEnd != seg) {
+    Symbol key;
+    key.address = offset - seg->offset + seg->address;
+    std::vector<Symbol>::const_iterator sym =
+        std::upper_bound(mod.symbols.begin(), mod.symbols.end(), key);
+    if (mod.symbols.begin() != sym) {
+      --sym;
+      if (key.address < sym->address + std::max<uint64_t>(sym->size, 1))
+        return demangle(sym->name);
+    }
+  }
+  return "[" + Path(mapping->path).filename().native() + "]";
+}
+
+const Symbolizer::Mapping* Symbolizer::findMapping(uint64_t pAddress)
+{
+  for (int pass = 0; pass < 2; ++pass) {
+    std::vector<Mapping>::const_iterator map, mEnd = m_Mappings.end();
+    for (map = m_Mappings.begin(); map != mEnd; ++map) {
+      if (map->start <= pAddress && pAddress < map->end)
+        return &*map;
+    }
+    if (0 == pass)
+      loadMappings();
+  }
+  return NULL;
+}
+
+const Symbolizer::Module& Symbolizer::module(const std::string& pPath)
+{
+  ModuleMap::iterator mod = m_Modules.find(pPath);
+  if (m_Modules.end() != mod)
+    return mod->second;
+
+  Module& result = m_Modules[pPath];
+  loadModule(pPath, result);
+  std::sort(result.symbols.begin(), result.symbols.end());
+  return result;
+}
+
+//===----------------------------------------------------------------------===//
+// Symbolizer Implementation
+//===----------------------------------------------------------------------===//
+#if defined(SKYPAT_ON_WIN32)
+#include "Windows/Symbolizer.inc"
+#endif
+
+#if defined(SKYPAT_ON_UNIX)
+#include "Unix/Symbolizer.inc"
+#endif
+
+#if defined(SKYPAT_ON_DRAGON)
+#include "Dragon/Symbolizer.inc"
+#endif
@@ -0,0 +1,36 @@
+//===- Barrier.cpp --------------------------------------------------------===//
+//
+//                              The SkyPat team 
+//
+// This file is distributed under the New BSD License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#include <skypat/Thread/Barrier.h>
+
+using namespace skypat;
+
+//===----------------------------------------------------------------------===//
+// Barrier
+//===----------------------------------------------------------------------===//
+Barrier::Barrier(unsigned int pCount)
+  : m_Mutex(), m_Condition(), m_Count(pCount), m_Waiting(0),
+    m_Generation(0) {
+}
+
+void Barrier::wait()
+{
+  ScopedLock lock(m_Mutex);
+  unsigned int generation = m_Generation;
+  if (++m_Waiting == m_Count) {
+    // the last one releases the round
+    m_Waiting = 0;
+    ++m_Generation;
+    m_Condition.wakeAll();
+    return;
+  }
+
+  // wake-ups may be spurious, so wait until the round changes
+  while (generation == m_Generation)
+    m_Condition.wait(m_Mutex);
+}
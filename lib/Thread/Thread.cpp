@@ -30,6 +30,16 @@ HANDLE Thread::getThreadID() const
   return (HANDLE)impl()->thread_id;
 }
 
+void Thread::setAffinity(const std::vector<int>& pCPUs)
+{
+  m_pThreadImpl->cpus = pCPUs;
+}
+
+void Thread::setRealTime(int pPriority)
+{
+  m_pThreadImpl->priority = pPriority;
+}
+
 const ThreadData* Thread::data() const
 {
   assert(NULL != m_pThreadImpl->data &&
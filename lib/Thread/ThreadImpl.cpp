@@ -27,7 +27,7 @@ void ThreadData::SetUp(ThreadData*& pData, Thread& pParent)
 // ThreadImpl
 //===----------------------------------------------------------------------===//
 ThreadImpl::ThreadImpl(Thread* pParent)
-  : data(NULL), parent(pParent) {
+  : data(NULL), parent(pParent), cpus(), priority(0) {
 }
 
 ThreadImpl::~ThreadImpl()
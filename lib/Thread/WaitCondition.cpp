@@ -0,0 +1,20 @@
+//===- WaitCondition.cpp --------------------------------------------------===//
+//
+//                              The SkyPat team 
+//
+// This file is distributed under the New BSD License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+#include <skypat/Thread/WaitCondition.h>
+#include <skypat/Thread/Mutex.h>
+#include <skypat/Thread/MutexImpl.h>
+#include <skypat/Config/Config.h>
+
+using namespace skypat;
+
+#if defined(HAVE_PTHREAD)
+#include "Pthread/WaitCondition.inc"
+#else
+#include "Quick/WaitCondition.inc"
+#endif
@@ -9,6 +9,8 @@
 #include <skypat/skypat.h>
 #include <skypat/Support/Timer.h>
 #include <skypat/Support/Perf.h>
+#include <skypat/Support/Scheduler.h>
+#include <skypat/Support/Sampler.h>
 #include <skypat/Support/ManagedStatic.h>
 #include <skypat/Support/OStrStream.h>
 #include <vector>
@@ -26,8 +28,17 @@
 
 using namespace skypat;
 
-/* Define the numebr of iteration of performance loop */
-#define SKYPAT_PERFORM_LOOP_TIMES 1
+/* Define the default minimum measured time of a PERFORM region (ns) */
+#define SKYPAT_PERFORM_MIN_TIME 10000000
+
+/* Define the default upper bound of iterations of a PERFORM region */
+#define SKYPAT_PERFORM_MAX_ITERATIONS 1000000000
+
+/* Define the default number of samples of a PERFORM region */
+#define SKYPAT_PERFORM_REPETITIONS 5
+
+/* Define the default number of warmup iterations of a PERFORM region */
+#define SKYPAT_PERFORM_WARMUP_ITERATIONS 1
 
 namespace skypat{
 /* Establish perf event string array */
@@ -41,13 +52,59 @@ char const *Perf_event_name[] = {
   "PAGEFAULTS", "CTX SWITCH",
   "CPUMIGRATE", "PG FAULT m",
   "PG FAULT M", "ALIGNFAULT",
-  "EMU  FAULT", "D U M M Y "
+  "EMU  FAULT", "D U M M Y ",
+  "L1D  R ACC", "L1D  R MIS",
+  "L1D  W ACC", "L1D  W MIS",
+  "L1D  P ACC", "L1D  P MIS",
+  "L1I  R ACC", "L1I  R MIS",
+  "L1I  W ACC", "L1I  W MIS",
+  "L1I  P ACC", "L1I  P MIS",
+  "LL   R ACC", "LL   R MIS",
+  "LL   W ACC", "LL   W MIS",
+  "LL   P ACC", "LL   P MIS",
+  "DTLB R ACC", "DTLB R MIS",
+  "DTLB W ACC", "DTLB W MIS",
+  "DTLB P ACC", "DTLB P MIS",
+  "ITLB R ACC", "ITLB R MIS",
+  "ITLB W ACC", "ITLB W MIS",
+  "ITLB P ACC", "ITLB P MIS",
+  "BPU  R ACC", "BPU  R MIS",
+  "BPU  W ACC", "BPU  W MIS",
+  "BPU  P ACC", "BPU  P MIS",
+  "NODE R ACC", "NODE R MIS",
+  "NODE W ACC", "NODE W MIS",
+  "NODE P ACC", "NODE P MIS"
 };
 } // namespace of skypat
 
+/// The innermost PERFORM region of the calling thread.
+static thread_local testing::PerfIterator* g_pCurrentRegion = NULL;
+
 //===----------------------------------------------------------------------===//
 // Non-member function
 //===----------------------------------------------------------------------===//
+void testing::internal::UseCharPointer(char const volatile*)
+{
+}
+
+void skypat::PauseTiming()
+{
+  if (NULL != g_pCurrentRegion)
+    g_pCurrentRegion->pause();
+}
+
+void skypat::ResumeTiming()
+{
+  if (NULL != g_pCurrentRegion)
+    g_pCurrentRegion->resume();
+}
+
+void skypat::Lap(const char* pName)
+{
+  if (NULL != g_pCurrentRegion)
+    g_pCurrentRegion->lap(pName);
+}
+
 testing::TestInfo*
 testing::MakeAndRegisterTestInfo(const char* pCaseName, const char* pTestName,
                                  testing::TestFactoryBase* pFactory)
@@ -71,54 +128,663 @@ std::string testing::GetBoolAssertionFailureMessage(
   return result;
 }
 
+/// Predict the number of iterations of the next batch from the elapsed time
+/// of the current one. Like other benchmark harnesses, we aim a bit beyond
+/// the minimum time and never grow more than ten times at once, since the
+/// first few batches are too short to be trusted.
+static uint64_t
+NextIterations(uint64_t pIterations, testing::Interval pElapsed,
+               testing::Interval pMinTime, uint64_t pMaxIterations)
+{
+  double multiplier = 10.0;
+  if (pElapsed > pMinTime / 10)
+    multiplier = std::min(10.0, 1.4 * pMinTime / pElapsed);
+
+  uint64_t next = static_cast<uint64_t>(pIterations * multiplier);
+  next = std::max(next, pIterations + 1);
+  return std::min(next, pMaxIterations);
+}
+
+/// The events of a region followed by the events of the run, such as those
+/// given by -e. An event is counted only once.
+static std::vector<enum PerfEvent>
+GroupEvents(const testing::PerfSpec& pSpec, const testing::RunOptions& pOptions)
+{
+  std::vector<enum PerfEvent> events(pSpec.events());
+  for (unsigned int i = 0; i < pOptions.getEvents().size(); ++i) {
+    enum PerfEvent event = pOptions.getEvents()[i];
+    if (events.end() == std::find(events.begin(), events.end(), event))
+      events.push_back(event);
+  }
+  return events;
+}
+
+/// The name of a region, or its line if it has none.
+static std::string Label(const testing::PerfPartResult& pResult)
+{
+  std::string result = pResult.getName();
+  if (result.empty()) {
+    OStrStream OS(result);
+    OS << pResult.lineNumber();
+  }
+  return result;
+}
+
+/// @return true if two results are of the same region of a test, such as
+/// a PERFORM run twice, and of the same threads.
+static bool IsSameRegion(const testing::PerfPartResult& pA,
+                         const testing::PerfPartResult& pB)
+{
+  return pA.getParent() == pB.getParent() && Label(pA) == Label(pB) &&
+         pA.getNumOfThreads() == pB.getNumOfThreads() &&
+         pA.getThreadIndex() == pB.getThreadIndex() &&
+         pA.getThreadResults().empty() == pB.getThreadResults().empty();
+}
+
+/// The backends that counted a region: "perf" when perf_event counted all,
+/// else the distinct backends of the timer and the events, such as
+/// "cputime+rusage+none".
+static std::string Backend(const testing::internal::Perf& pPerf)
+{
+  std::vector<std::string> backends(1, testing::internal::Timer::backend());
+  for (unsigned int i = 0; i < pPerf.size(); ++i) {
+    std::string backend = pPerf.backend(i);
+    if (backends.end() == std::find(backends.begin(), backends.end(), backend))
+      backends.push_back(backend);
+  }
+
+  std::string result = backends.front();
+  for (unsigned int i = 1; i < backends.size(); ++i)
+    result += "+" + backends[i];
+  return result;
+}
+
+//===----------------------------------------------------------------------===//
+// RunOptions
+//===----------------------------------------------------------------------===//
+testing::RunOptions::RunOptions()
+  : m_MinTime(SKYPAT_PERFORM_MIN_TIME),
+    m_MaxIterations(SKYPAT_PERFORM_MAX_ITERATIONS),
+    m_Iterations(0),
+    m_Repetitions(SKYPAT_PERFORM_REPETITIONS),
+    m_Warmup(SKYPAT_PERFORM_WARMUP_ITERATIONS),
+    m_CPUs(), m_RealTimePriority(0), m_Events(), m_Sampling() {
+}
+
+//===----------------------------------------------------------------------===//
+// RawEvent
+//===----------------------------------------------------------------------===//
+testing::RawEvent::RawEvent(const std::string& pName)
+  : m_Name(pName), m_Event(CONTEXT_SWITCHES), m_bIsValid(false) {
+  m_bIsValid = internal::Perf::addEvent(pName, m_Event);
+}
+
+//===----------------------------------------------------------------------===//
+// PerfSpec
+//===----------------------------------------------------------------------===//
+testing::PerfSpec::PerfSpec()
+  : m_Events(), m_Warmup(), m_bHasWarmup(false),
+    m_Latency(), m_bHasLatency(false), m_Throughput(),
+    m_Sampling(), m_bHasSampling(false), m_Name() {
+}
+
+testing::PerfSpec::PerfSpec(enum PerfEvent pEvent)
+  : m_Events(1, pEvent), m_Warmup(), m_bHasWarmup(false),
+    m_Latency(), m_bHasLatency(false), m_Throughput(),
+    m_Sampling(), m_bHasSampling(false), m_Name() {
+}
+
+void testing::PerfSpec::add(const RawEvent& pEvent)
+{
+  if (pEvent.isValid())
+    m_Events.push_back(pEvent.event());
+  else
+    Log::getOStream() << "Unknown perf event `" << pEvent.name() << "`\n";
+}
+
 //===----------------------------------------------------------------------===//
 // PerfIterator
 //===----------------------------------------------------------------------===//
 testing::PerfIterator::PerfIterator(const char* pFile, int pLine)
-  : m_Counter(0),
-    m_pTimer(new internal::Timer()),
-    m_pPerf(new internal::Perf()),
-    m_pPerfResult(testing::UnitTest::self()->addPerfPartResult(pFile, pLine)) {
-
-  m_pTimer->start();
-  m_pPerf->start();
+  : PerfIterator(pFile, pLine, PerfSpec()) {
 }
 
 testing::PerfIterator::PerfIterator(const char* pFile, int pLine,\
 									enum PerfEvent pEvent)
+  : PerfIterator(pFile, pLine, PerfSpec(pEvent)) {
+}
+
+testing::PerfIterator::PerfIterator(const char* pFile, int pLine,
+                                    const PerfSpec& pSpec)
+  : PerfIterator(resultOf(pFile, pLine), pSpec, UnitTest::self()->options()) {
+}
+
+testing::PerfIterator::PerfIterator(const char* pFile, int pLine,
+                                    const PerfSpec& pSpec,
+                                    internal::Timer& pTimer,
+                                    internal::Perf& pPerf)
+  : PerfIterator(resultOf(pFile, pLine), pSpec, UnitTest::self()->options(),
+                 &pTimer, &pPerf) {
+}
+
+testing::PerfIterator::PerfIterator(PerfPartResult& pResult,
+                                    const PerfSpec& pSpec,
+                                    const RunOptions& pOptions)
+  : PerfIterator(pResult, pSpec, pOptions, NULL, NULL) {
+}
+
+testing::PerfIterator::PerfIterator(PerfPartResult& pResult,
+                                    const PerfSpec& pSpec,
+                                    const RunOptions& pOptions,
+                                    internal::Timer* pTimer,
+                                    internal::Perf* pPerf)
   : m_Counter(0),
-    m_pTimer(new internal::Timer()),
-    m_pPerf(new internal::Perf(pEvent)),
-    m_pPerfResult(testing::UnitTest::self()->addPerfPartResult(pFile, pLine)) {
+    m_Iterations(1),
+    m_Phase(kCalibrate),
+    m_Options(pOptions),
+    m_Warmup(pSpec.hasWarmup() ? pSpec.warmup() : pOptions.getWarmup()),
+    m_Latency(pSpec.latency()),
+    m_bHasLatency(pSpec.hasLatency()),
+    m_LastTick(0),
+    m_PauseTick(0),
+    m_Pauses(0),
+    m_pTimer(pTimer),
+    m_pPerf(pPerf),
+    m_pSampler(NULL),
+    m_pPerfResult(&pResult),
+    m_pParent(g_pCurrentRegion),
+    m_pRoot((NULL != g_pCurrentRegion) ? g_pCurrentRegion->m_pRoot : this),
+    m_bOwnsTimer(false),
+    m_bOwnsPerf(false),
+    m_Nested(),
+    m_bHasLaps(false),
+    m_Laps(),
+    m_LapIdx(0),
+    m_LapTime(0),
+    m_LapEvents(),
+    m_LapBuffer() {
 
+  g_pCurrentRegion = this;
+  m_pPerfResult->setThroughput(pSpec.throughput());
+  if (!pSpec.name().empty())
+    m_pPerfResult->setName(pSpec.name());
+
+  if (NULL != m_pParent) {
+    // The body runs once for every iteration of the parent, inside the
+    // window of the parent. The outermost region keeps the counters of
+    // every nested region, so that only the first run allocates them.
+    m_Phase = kNested;
+    NestedRegion* region = m_pRoot->findNested(&pResult);
+    if (NULL == region) {
+      initCounters(pSpec, pOptions);
+      NestedRegion added;
+      added.result = m_pPerfResult;
+      added.timer = m_bOwnsTimer ? m_pTimer : NULL;
+      added.perf = m_bOwnsPerf ? m_pPerf : NULL;
+      added.time = 0;
+      for (unsigned int i = 0; i < m_pPerf->size(); ++i)
+        added.types.push_back(m_pPerf->eventType(i));
+      added.events.assign(m_pPerf->size(), 0);
+      m_pRoot->m_Nested.push_back(added);
+      m_bOwnsTimer = false;
+      m_bOwnsPerf = false;
+    }
+    else {
+      // NULL stands for the counters of the caller
+      if (NULL != region->timer)
+        m_pTimer = region->timer;
+      if (NULL != region->perf)
+        m_pPerf = region->perf;
+    }
+    m_pTimer->start();
+    m_pPerf->start();
+    return;
+  }
+  initCounters(pSpec, pOptions);
+
+  // the sampler runs for the lifetime of the region
+  const Sampling& sampling = pSpec.hasSampling() ? pSpec.sampling()
+                                                 : pOptions.getSampling();
+  if (sampling.isEnabled()) {
+    m_pSampler = new internal::Sampler(sampling.period());
+    m_pSampler->start();
+  }
+
+  // iterations calibrated by the caller, such as by PERFORM_THREADS
+  if (0 != pOptions.getIterations()) {
+    m_Iterations = pOptions.getIterations();
+    m_Warmup = Warmup();
+  }
+
+  // The first batch of the warmup is a single call, so that the cost of a
+  // cold call is separated from the rest of the warmup.
   m_pTimer->start();
-  m_pPerf->start();
+  if (m_Warmup.isEnabled())
+    m_Phase = kWarmup;
+  else
+    m_pPerf->start();
 }
 
 testing::PerfIterator::~PerfIterator()
 {
-  delete m_pTimer;
-  delete m_pPerf;
+  g_pCurrentRegion = m_pParent;
+  if (m_bOwnsTimer)
+    delete m_pTimer;
+  if (m_bOwnsPerf)
+    delete m_pPerf;
+
+  NestedList::iterator region, rEnd = m_Nested.end();
+  for (region = m_Nested.begin(); region != rEnd; ++region) {
+    delete region->timer;
+    delete region->perf;
+  }
+
+  if (NULL != m_pSampler) {
+    m_pSampler->stop();
+    m_pPerfResult->setProfile(m_pSampler->profile());
+    delete m_pSampler;
+  }
 }
 
-bool testing::PerfIterator::hasNext() const
+void testing::PerfIterator::initCounters(const PerfSpec& pSpec,
+                                         const RunOptions& pOptions)
 {
-  if (m_Counter < SKYPAT_PERFORM_LOOP_TIMES)
-    return true;
+  if (NULL == m_pTimer) {
+    m_pTimer = new internal::Timer();
+    m_bOwnsTimer = true;
+  }
+
+  // A nested region counts the events of its parent, too, so that they
+  // can be left out of the exclusive costs of the parent. The counters of
+  // the caller are used only if they count all of them.
+  std::vector<enum PerfEvent> events;
+  if (NULL == m_pPerf)
+    events = GroupEvents(pSpec, pOptions);
+  else {
+    for (unsigned int i = 0; i < m_pPerf->size(); ++i)
+      events.push_back(static_cast<enum PerfEvent>(m_pPerf->eventType(i)));
+  }
+  unsigned int own_events = events.size();
+  for (unsigned int i = 0; NULL != m_pParent &&
+                           i < m_pParent->m_pPerf->size(); ++i) {
+    enum PerfEvent event =
+        static_cast<enum PerfEvent>(m_pParent->m_pPerf->eventType(i));
+    if (events.end() == std::find(events.begin(), events.end(), event))
+      events.push_back(event);
+  }
+  if (NULL == m_pPerf || own_events != events.size()) {
+    m_pPerf = new internal::Perf(events);
+    m_bOwnsPerf = true;
+  }
+}
+
+testing::PerfIterator* testing::PerfIterator::current()
+{
+  return g_pCurrentRegion;
+}
+
+testing::PerfPartResult&
+testing::PerfIterator::resultOf(const char* pFile, int pLine)
+{
+  if (NULL == g_pCurrentRegion)
+    return *UnitTest::self()->addPerfPartResult(pFile, pLine);
+
+  PerfPartResult& parent = *g_pCurrentRegion->m_pPerfResult;
+  PerfPartResult* result = parent.findChild(pFile, pLine);
+  if (NULL == result) {
+    result = UnitTest::self()->addPerfPartResult(pFile, pLine);
+    parent.addChild(*result);
+  }
+  return *result;
+}
+
+void testing::PerfIterator::pause()
+{
+  // the time a nested region pauses is left out of its parents, too
+  if (kNested == m_Phase)
+    m_pParent->pause();
+
+  ++m_Pauses;
+  if (kLatency == m_Phase) {
+    m_PauseTick = internal::CycleClock::now();
+    return;
+  }
+  m_pTimer->pause();
+  if (m_pPerf->isActive())
+    m_pPerf->pause();
+}
+
+void testing::PerfIterator::resume()
+{
+  if (kLatency == m_Phase) {
+    m_LastTick += internal::CycleClock::now() - m_PauseTick;
+    return;
+  }
+  if (m_pPerf->isActive())
+    m_pPerf->resume();
+  m_pTimer->resume();
 
+  if (kNested == m_Phase)
+    m_pParent->resume();
+}
+
+void testing::PerfIterator::lap(const char* pName)
+{
+  if (kCalibrate != m_Phase && kSample != m_Phase)
+    return;
+
+  Interval time = m_pTimer->elapsed();
+  if (!m_bHasLaps) {
+    m_bHasLaps = true;
+    m_LapEvents.assign(m_pPerf->size(), 0);
+    m_LapBuffer.resize(m_pPerf->size());
+  }
+  m_pPerf->snapshot(m_LapBuffer.data());
+
+  // The laps of an iteration mostly come in the same order, so the phase
+  // is looked up only if it is not the one after the previous lap.
+  if (m_LapIdx >= m_Laps.size() || m_Laps[m_LapIdx].name != pName) {
+    m_LapIdx = 0;
+    while (m_LapIdx < m_Laps.size() && m_Laps[m_LapIdx].name != pName)
+      ++m_LapIdx;
+    if (m_Laps.size() == m_LapIdx) {
+      LapTotal total;
+      total.name = pName;
+      total.time = 0;
+      total.events.assign(m_pPerf->size(), 0);
+      m_Laps.push_back(total);
+    }
+  }
+
+  LapTotal& total = m_Laps[m_LapIdx];
+  total.time += time - m_LapTime;
+  for (unsigned int i = 0; i < total.events.size(); ++i)
+    total.events[i] += m_LapBuffer[i] - m_LapEvents[i];
+
+  m_LapTime = time;
+  m_LapEvents.swap(m_LapBuffer);
+  m_LapIdx = (m_LapIdx + 1) % m_Laps.size();
+}
+
+void testing::PerfIterator::endLaps()
+{
+  lap("(rest)");
+}
+
+void testing::PerfIterator::sampleLaps()
+{
+  std::vector<double> events;
+  LapList::iterator total, tEnd = m_Laps.end();
+  for (total = m_Laps.begin(); total != tEnd; ++total) {
+    events.resize(total->events.size());
+    for (unsigned int i = 0; i < total->events.size(); ++i)
+      events[i] = double(total->events[i]) / m_Iterations;
+    m_pPerfResult->addLapSample(total->name,
+                                double(total->time) / m_Iterations, events);
+  }
+  resetLaps();
+}
+
+void testing::PerfIterator::resetLaps()
+{
+  // keep the phases, so that a phase left out of a batch samples zero
+  LapList::iterator total, tEnd = m_Laps.end();
+  for (total = m_Laps.begin(); total != tEnd; ++total) {
+    total->time = 0;
+    std::fill(total->events.begin(), total->events.end(), 0);
+  }
+  m_LapIdx = 0;
+  m_LapTime = 0;
+  std::fill(m_LapEvents.begin(), m_LapEvents.end(), 0);
+}
+
+testing::PerfIterator::NestedRegion*
+testing::PerfIterator::findNested(const PerfPartResult* pResult)
+{
+  NestedList::iterator region, rEnd = m_Nested.end();
+  for (region = m_Nested.begin(); region != rEnd; ++region) {
+    if (region->result == pResult)
+      return &*region;
+  }
+  return NULL;
+}
+
+void testing::PerfIterator::exclude(const PerfPartResult& pResult,
+                                    const std::vector<Interval>& pTypes,
+                                    double& pTime,
+                                    std::vector<double>& pEvents) const
+{
+  NestedList::const_iterator child, cEnd = m_Nested.end();
+  for (child = m_Nested.begin(); child != cEnd; ++child) {
+    if (&pResult != child->result->getParent())
+      continue;
+
+    pTime -= double(child->time) / m_Iterations;
+    for (unsigned int i = 0; i < pTypes.size(); ++i) {
+      std::vector<Interval>::const_iterator type =
+          std::find(child->types.begin(), child->types.end(), pTypes[i]);
+      if (child->types.end() != type)
+        pEvents[i] -= double(child->events[type - child->types.begin()]) /
+                      m_Iterations;
+    }
+  }
+
+  // the counts of the parent and the child are read at different moments
+  pTime = std::max(pTime, 0.0);
+  for (unsigned int i = 0; i < pEvents.size(); ++i)
+    pEvents[i] = std::max(pEvents[i], 0.0);
+}
+
+void testing::PerfIterator::sampleNested(double pTime,
+                                         const std::vector<double>& pEvents)
+{
+  std::vector<Interval> types(m_pPerf->size());
+  for (unsigned int i = 0; i < m_pPerf->size(); ++i)
+    types[i] = m_pPerf->eventType(i);
+
+  double time = pTime;
+  std::vector<double> events(pEvents);
+  exclude(*m_pPerfResult, types, time, events);
+  m_pPerfResult->addExclusiveSample(time, events);
+
+  NestedList::iterator region, rEnd = m_Nested.end();
+  for (region = m_Nested.begin(); region != rEnd; ++region) {
+    PerfPartResult& result = *region->result;
+    if (0 == result.getNumOfPerfEvents()) {
+      for (unsigned int i = 0; i < region->types.size(); ++i)
+        result.addPerfEvent(region->types[i]);
+    }
+    result.setIterations(m_Iterations);
+    // a nested region runs on the cores of its parent
+    for (unsigned int i = 0; i < m_pPerfResult->getCPUs().size(); ++i)
+      result.addCPU(m_pPerfResult->getCPUs()[i]);
+
+    time = double(region->time) / m_Iterations;
+    events.resize(region->events.size());
+    for (unsigned int i = 0; i < region->events.size(); ++i)
+      events[i] = double(region->events[i]) / m_Iterations;
+    result.addSample(time, events);
+
+    if (result.hasChildren()) {
+      exclude(result, region->types, time, events);
+      result.addExclusiveSample(time, events);
+    }
+  }
+  resetNested();
+}
+
+void testing::PerfIterator::resetNested()
+{
+  // keep the regions, so that a region left out of a batch samples zero
+  NestedList::iterator region, rEnd = m_Nested.end();
+  for (region = m_Nested.begin(); region != rEnd; ++region) {
+    region->time = 0;
+    std::fill(region->events.begin(), region->events.end(), 0);
+  }
+}
+
+void testing::PerfIterator::finishNested()
+{
+  NestedList::iterator region, rEnd = m_Nested.end();
+  for (region = m_Nested.begin(); region != rEnd; ++region) {
+    region->result->setOverhead(UnitTest::self()->overhead());
+    region->result->summarize();
+  }
+}
+
+void testing::PerfIterator::warmUp()
+{
   m_pTimer->stop();
-  m_pPerf->stop();
+  resetNested();
+
+  if (0 == m_pPerfResult->getWarmupIterations())
+    m_pPerfResult->setFirstCallTime(m_pTimer->interval());
+
+  uint64_t iterations = m_pPerfResult->getWarmupIterations() + m_Iterations;
+  Interval time = m_pPerfResult->getWarmupTime() + m_pTimer->interval();
+  m_pPerfResult->setWarmup(iterations, time);
+
+  if (iterations < m_Warmup.iterations()) {
+    m_Iterations = m_Warmup.iterations() - iterations;
+  }
+  else if (time < m_Warmup.time()) {
+    m_Iterations = NextIterations(m_Iterations, m_pTimer->interval(),
+                                  m_Warmup.time() - time,
+                                  m_Options.getMaxIterations());
+  }
+  else {
+    // Warm enough. Calibrate from scratch with the counters on.
+    m_Phase = kCalibrate;
+    m_Iterations = 1;
+    m_Counter = 0;
+    m_pTimer->start();
+    m_pPerf->start();
+    return;
+  }
+
+  m_Counter = 0;
+  m_pTimer->start();
+}
 
-  m_pPerfResult->setTimerNum(m_pTimer->interval());
-  m_pPerfResult->setPerfEventNum(m_pPerf->interval());
-  m_pPerfResult->setPerfEventType(m_pPerf->eventType());
+bool testing::PerfIterator::timeIteration()
+{
+  uint64_t tick = internal::CycleClock::now();
+  Histogram& latency = m_pPerfResult->getLatency();
+  latency.record((tick - m_LastTick) * internal::CycleClock::nsPerTick() + 0.5);
+  m_LastTick = tick;
+
+  if (latency.count() < m_Latency.iterations()) {
+    m_Counter = 0;
+    return true;
+  }
   return false;
 }
 
-testing::PerfIterator& testing::PerfIterator::next()
+bool testing::PerfIterator::nextBatch()
 {
-  ++m_Counter;
-  return *this;
+  uint64_t pauses = m_Pauses;
+  m_Pauses = 0;
+
+  if (kNested == m_Phase) {
+    // add the costs of this run to the outermost region, which samples
+    // them with its batch
+    m_pTimer->stop();
+    m_pPerf->stop();
+    if (m_pPerfResult->getReadPath().empty()) {
+      m_pPerfResult->setReadPath(m_pPerf->readPath());
+      m_pPerfResult->setBackend(Backend(*m_pPerf));
+    }
+
+    NestedRegion& region = *m_pRoot->findNested(m_pPerfResult);
+    region.time += m_pTimer->interval();
+    for (unsigned int i = 0; i < region.events.size(); ++i)
+      region.events[i] += m_pPerf->interval(i);
+    return false;
+  }
+
+  if (kWarmup == m_Phase) {
+    warmUp();
+    return true;
+  }
+
+  if (kLatency == m_Phase) {
+    if (timeIteration())
+      return true;
+    m_pPerfResult->summarize();
+    return false;
+  }
+
+  m_pTimer->stop();
+  m_pPerf->stop();
+  // the core the batch ended on, outside of the measured region
+  m_pPerfResult->addCPU(internal::Scheduler::currentCPU());
+  // empty the ring buffer of the sampler before it overflows
+  if (NULL != m_pSampler)
+    m_pSampler->drain();
+
+  const RunOptions& options = m_Options;
+  if (kCalibrate == m_Phase) {
+    if (0 == options.getIterations() &&
+        m_pTimer->interval() < options.getMinTime() &&
+        m_Iterations < options.getMaxIterations()) {
+      // The batch is too short to be measured precisely. Start a larger one.
+      resetNested();
+      resetLaps();
+      m_Iterations = NextIterations(m_Iterations, m_pTimer->interval(),
+                                    options.getMinTime(),
+                                    options.getMaxIterations());
+      m_Counter = 0;
+      m_pTimer->start();
+      m_pPerf->start();
+      return true;
+    }
+    // The last calibrating batch is long enough to be the first sample.
+    m_Phase = kSample;
+    m_pPerfResult->setIterations(m_Iterations);
+    for (unsigned int i = 0; i < m_pPerf->size(); ++i)
+      m_pPerfResult->addPerfEvent(m_pPerf->eventType(i));
+  }
+
+  std::vector<double> events(m_pPerf->size());
+  for (unsigned int i = 0; i < m_pPerf->size(); ++i)
+    events[i] = double(m_pPerf->interval(i)) / m_Iterations;
+  double time = double(m_pTimer->interval()) / m_Iterations;
+  m_pPerfResult->addSample(time, events);
+  if (!m_Nested.empty())
+    sampleNested(time, events);
+  if (!m_Laps.empty())
+    sampleLaps();
+  m_pPerfResult->addPauses(double(pauses) / m_Iterations);
+  m_pPerfResult->addRunningRatio(m_pPerf->ratio());
+
+  if (m_pPerfResult->getTimerSamples().size() < options.getRepetitions()) {
+    m_Counter = 0;
+    m_pTimer->start();
+    m_pPerf->start();
+    return true;
+  }
+
+  m_pPerfResult->setReadPath(m_pPerf->readPath());
+  m_pPerfResult->setBackend(Backend(*m_pPerf));
+  m_pPerfResult->setOverhead(UnitTest::self()->overhead());
+  finishNested();
+
+  if (m_bHasLatency) {
+    // Time the iterations one by one. Every iteration ends in nextBatch(),
+    // which reads the clock and records into the preallocated buckets.
+    if (0 == m_Latency.iterations())
+      m_Latency = Latency(m_Iterations * options.getRepetitions());
+    m_pPerfResult->getLatency().reset();
+    m_Phase = kLatency;
+    m_Iterations = 1;
+    m_Counter = 0;
+    internal::CycleClock::nsPerTick();
+    m_LastTick = internal::CycleClock::now();
+    return true;
+  }
+
+  m_pPerfResult->summarize();
+  return false;
 }
 
 //===----------------------------------------------------------------------===//
@@ -157,7 +823,17 @@ testing::TestPartResult::appendUserMessage(const std::string& pMessage)
 //===----------------------------------------------------------------------===//
 testing::PerfPartResult::PerfPartResult(const std::string& pFileName,
                                         int pLoC)
-  : PartResult(pFileName, pLoC) {
+  : PartResult(pFileName, pLoC),
+    m_PerfTimerNum(0), m_TimerOverhead(0.0), m_PauseOverhead(0.0),
+    m_PausesPerIteration(0.0), m_PauseBatches(0), m_Iterations(0),
+    m_WarmupIterations(0), m_WarmupTime(0),
+    m_FirstCallTime(0), m_ReadPath(), m_Backend("perf"), m_Latency(),
+    m_Throughput(),
+    m_NumOfThreads(1), m_ThreadIdx(-1), m_IterationsPerSecond(0.0),
+    m_Speedup(0.0), m_Scalability(), m_ThreadResults(), m_CPUs(),
+    m_RunningRatio(1.0), m_Profile(), m_Name(), m_pParentResult(NULL),
+    m_Depth(0),
+    m_Children(), m_ExclusiveSamples(), m_ExclusiveStats(), m_Laps() {
 }
 
 testing::Interval testing::PerfPartResult::getTimerNum() const
@@ -165,14 +841,25 @@ testing::Interval testing::PerfPartResult::getTimerNum() const
   return m_PerfTimerNum;
 }
 
-testing::Interval testing::PerfPartResult::getPerfEventNum() const
+testing::Interval
+testing::PerfPartResult::getPerfEventNum(unsigned int pIdx) const
 {
-  return m_PerfEventNum;
+  if (pIdx >= m_PerfEvents.size())
+    return 0;
+  return m_PerfEvents[pIdx].num;
 }
 
-testing::Interval testing::PerfPartResult::getPerfEventType() const
+testing::Interval
+testing::PerfPartResult::getPerfEventType(unsigned int pIdx) const
 {
-  return m_PerfEventType;
+  if (pIdx >= m_PerfEvents.size())
+    return 0;
+  return m_PerfEvents[pIdx].type;
+}
+
+uint64_t testing::PerfPartResult::getIterations() const
+{
+  return m_Iterations;
 }
 
 void testing::PerfPartResult::setTimerNum(testing::Interval pTimerNum)
@@ -182,14 +869,310 @@ void testing::PerfPartResult::setTimerNum(testing::Interval pTimerNum)
   os << pTimerNum << " ns;";
 }
 
-void testing::PerfPartResult::setPerfEventNum(testing::Interval pEventNum)
+void testing::PerfPartResult::addPerfEvent(testing::Interval pEventType)
+{
+  PerfEventResult event;
+  event.type = pEventType;
+  event.num = 0;
+  event.overhead = 0.0;
+  event.pause_overhead = 0.0;
+  event.calibrated = false;
+  m_PerfEvents.push_back(event);
+}
+
+double testing::PerfPartResult::getPerfEventOverhead(unsigned int pIdx) const
+{
+  if (pIdx >= m_PerfEvents.size())
+    return 0.0;
+  return m_PerfEvents[pIdx].overhead;
+}
+
+double testing::PerfPartResult::getCorrectedTimerNum() const
+{
+  return std::max(m_TimerStats.median() - m_TimerOverhead -
+                  m_PausesPerIteration * m_PauseOverhead, 0.0);
+}
+
+bool testing::PerfPartResult::isTimerBelowOverhead() const
+{
+  double overhead = m_TimerOverhead + m_PausesPerIteration * m_PauseOverhead;
+  return 0.0 < overhead && m_TimerStats.median() <= overhead;
+}
+
+bool testing::PerfPartResult::isPerfEventCalibrated(unsigned int pIdx) const
+{
+  if (pIdx >= m_PerfEvents.size())
+    return false;
+  return m_PerfEvents[pIdx].calibrated;
+}
+
+double
+testing::PerfPartResult::getCorrectedPerfEventNum(unsigned int pIdx) const
+{
+  if (pIdx >= m_PerfEvents.size())
+    return 0.0;
+  const PerfEventResult& event = m_PerfEvents[pIdx];
+  return std::max(event.stats.median() - event.overhead -
+                  m_PausesPerIteration * event.pause_overhead, 0.0);
+}
+
+bool
+testing::PerfPartResult::isPerfEventBelowOverhead(unsigned int pIdx) const
+{
+  if (pIdx >= m_PerfEvents.size())
+    return false;
+  const PerfEventResult& event = m_PerfEvents[pIdx];
+  double overhead = event.overhead +
+                    m_PausesPerIteration * event.pause_overhead;
+  return 0.0 < overhead && event.stats.median() <= overhead;
+}
+
+double testing::PerfPartResult::getIterationsPerSecond() const
+{
+  if (!m_ThreadResults.empty())
+    return m_IterationsPerSecond;
+
+  double time = getCorrectedTimerNum();
+  if (0.0 == time)
+    return 0.0;
+  return 1e9 / time;
+}
+
+double testing::PerfPartResult::getEfficiency() const
+{
+  return m_Speedup / m_NumOfThreads;
+}
+
+double testing::PerfPartResult::getBytesPerSecond() const
+{
+  return m_Throughput.bytes() * getIterationsPerSecond();
+}
+
+double testing::PerfPartResult::getItemsPerSecond() const
+{
+  return m_Throughput.items() * getIterationsPerSecond();
+}
+
+double testing::PerfPartResult::getBytesPerCycle() const
 {
-  m_PerfEventNum = pEventNum;
+  for (unsigned int idx = 0; idx < m_PerfEvents.size(); ++idx) {
+    if (CPU_CYCLES != m_PerfEvents[idx].type)
+      continue;
+    double cycles = getCorrectedPerfEventNum(idx);
+    return (0.0 == cycles) ? 0.0 : m_Throughput.bytes() / cycles;
+  }
+  return 0.0;
+}
+
+double testing::PerfPartResult::getItemsPerCycle() const
+{
+  for (unsigned int idx = 0; idx < m_PerfEvents.size(); ++idx) {
+    if (CPU_CYCLES != m_PerfEvents[idx].type)
+      continue;
+    double cycles = getCorrectedPerfEventNum(idx);
+    return (0.0 == cycles) ? 0.0 : m_Throughput.items() / cycles;
+  }
+  return 0.0;
+}
+
+void testing::PerfPartResult::setOverhead(const Overhead& pOverhead)
+{
+  m_TimerOverhead = pOverhead.timer();
+  m_PauseOverhead = pOverhead.pauseTimer();
+  PerfEventList::iterator event, eEnd = m_PerfEvents.end();
+  for (event = m_PerfEvents.begin(); event != eEnd; ++event) {
+    event->overhead = pOverhead.event(event->type);
+    event->pause_overhead = pOverhead.pauseEvent(event->type);
+    event->calibrated = pOverhead.hasEvent(event->type);
+  }
+}
+
+void testing::PerfPartResult::setIterations(uint64_t pIterations)
+{
+  m_Iterations = pIterations;
+}
+
+void testing::PerfPartResult::setWarmup(uint64_t pIterations,
+                                        testing::Interval pTime)
+{
+  m_WarmupIterations = pIterations;
+  m_WarmupTime = pTime;
+}
+
+void testing::PerfPartResult::addSample(double pTime,
+                                        const std::vector<double>& pEventNums)
+{
+  m_TimerSamples.push_back(pTime);
+  for (unsigned int i = 0; i < m_PerfEvents.size(); ++i)
+    m_PerfEvents[i].samples.push_back(pEventNums[i]);
+}
+
+void testing::PerfPartResult::addExclusiveSample(
+    double pTime, const std::vector<double>& pEventNums)
+{
+  m_ExclusiveSamples.push_back(pTime);
+  for (unsigned int i = 0; i < m_PerfEvents.size(); ++i)
+    m_PerfEvents[i].exclusive_samples.push_back(pEventNums[i]);
+}
+
+void testing::PerfPartResult::addLapSample(
+    const std::string& pName, double pTime,
+    const std::vector<double>& pEventNums)
+{
+  LapList::iterator lap, lEnd = m_Laps.end();
+  for (lap = m_Laps.begin(); lap != lEnd; ++lap) {
+    if (pName == lap->name)
+      break;
+  }
+
+  if (lEnd == lap) {
+    LapResult result;
+    result.name = pName;
+    result.event_samples.resize(m_PerfEvents.size());
+    result.event_stats.resize(m_PerfEvents.size());
+    lap = m_Laps.insert(lEnd, result);
+  }
+
+  lap->samples.push_back(pTime);
+  for (unsigned int i = 0; i < lap->event_samples.size(); ++i)
+    lap->event_samples[i].push_back(pEventNums[i]);
+}
+
+void testing::PerfPartResult::summarize()
+{
+  m_TimerStats.compute(m_TimerSamples);
+  m_ExclusiveStats.compute(m_ExclusiveSamples);
+  setTimerNum(m_TimerStats.median() + 0.5);
+
+  PerfEventList::iterator event, eEnd = m_PerfEvents.end();
+  for (event = m_PerfEvents.begin(); event != eEnd; ++event) {
+    event->stats.compute(event->samples);
+    event->exclusive_stats.compute(event->exclusive_samples);
+    event->num = event->stats.median() + 0.5;
+  }
+
+  LapList::iterator lap, lEnd = m_Laps.end();
+  for (lap = m_Laps.begin(); lap != lEnd; ++lap) {
+    lap->stats.compute(lap->samples);
+    for (unsigned int i = 0; i < lap->event_samples.size(); ++i)
+      lap->event_stats[i].compute(lap->event_samples[i]);
+  }
+}
+
+const testing::Statistics&
+testing::PerfPartResult::getExclusiveTimerStats() const
+{
+  if (m_ExclusiveSamples.empty())
+    return m_TimerStats;
+  return m_ExclusiveStats;
 }
 
-void testing::PerfPartResult::setPerfEventType(testing::Interval pEventType)
+const testing::Statistics&
+testing::PerfPartResult::getExclusivePerfEventStats(unsigned int pIdx) const
 {
-  m_PerfEventType = pEventType;
+  const PerfEventResult& event = m_PerfEvents[pIdx];
+  if (event.exclusive_samples.empty())
+    return event.stats;
+  return event.exclusive_stats;
+}
+
+std::string testing::PerfPartResult::getRegion() const
+{
+  std::string region = Label(*this);
+  if (NULL == m_pParentResult)
+    return region;
+  return m_pParentResult->getRegion() + "/" + region;
+}
+
+void testing::PerfPartResult::addChild(PerfPartResult& pChild)
+{
+  pChild.m_pParentResult = this;
+  pChild.m_Depth = m_Depth + 1;
+  m_Children.push_back(&pChild);
+}
+
+testing::PerfPartResult*
+testing::PerfPartResult::findChild(const char* pFileName, int pLoC) const
+{
+  std::vector<PerfPartResult*>::const_iterator child, cEnd = m_Children.end();
+  for (child = m_Children.begin(); child != cEnd; ++child) {
+    if (pLoC == (*child)->lineNumber() && (*child)->filename() == pFileName)
+      return *child;
+  }
+  return NULL;
+}
+
+void testing::PerfPartResult::addCPU(int pCPU)
+{
+  if (0 > pCPU)
+    return;
+  std::vector<int>::iterator cpu =
+      std::lower_bound(m_CPUs.begin(), m_CPUs.end(), pCPU);
+  if (m_CPUs.end() == cpu || *cpu != pCPU)
+    m_CPUs.insert(cpu, pCPU);
+}
+
+void testing::PerfPartResult::aggregate(
+    const std::vector<const PerfPartResult*>& pThreads)
+{
+  if (pThreads.empty())
+    return;
+
+  m_ThreadResults = pThreads;
+  m_NumOfThreads = pThreads.size();
+  m_ThreadIdx = -1;
+
+  const PerfPartResult& first = *pThreads.front();
+  m_TimerOverhead = first.m_TimerOverhead;
+  m_PauseOverhead = first.m_PauseOverhead;
+  m_ReadPath = first.m_ReadPath;
+  m_Backend = first.m_Backend;
+  m_Throughput = first.m_Throughput;
+  for (unsigned int idx = 0; idx < first.m_PerfEvents.size(); ++idx) {
+    addPerfEvent(first.m_PerfEvents[idx].type);
+    m_PerfEvents[idx].overhead = first.m_PerfEvents[idx].overhead;
+    m_PerfEvents[idx].pause_overhead = first.m_PerfEvents[idx].pause_overhead;
+    m_PerfEvents[idx].calibrated = first.m_PerfEvents[idx].calibrated;
+  }
+
+  size_t samples = first.m_TimerSamples.size();
+  m_Iterations = 0;
+  m_WarmupIterations = 0;
+  m_WarmupTime = 0;
+  m_FirstCallTime = 0;
+  m_PausesPerIteration = 0.0;
+  m_Latency.reset();
+  std::vector<const PerfPartResult*>::const_iterator thread,
+                                                     tEnd = pThreads.end();
+  for (thread = pThreads.begin(); thread != tEnd; ++thread) {
+    samples = std::min(samples, (*thread)->m_TimerSamples.size());
+    m_Iterations += (*thread)->m_Iterations;
+    m_WarmupIterations += (*thread)->m_WarmupIterations;
+    m_WarmupTime = std::max(m_WarmupTime, (*thread)->m_WarmupTime);
+    m_FirstCallTime = std::max(m_FirstCallTime, (*thread)->m_FirstCallTime);
+    m_PausesPerIteration += (*thread)->m_PausesPerIteration / m_NumOfThreads;
+    m_Latency.merge((*thread)->m_Latency);
+    for (unsigned int idx = 0; idx < (*thread)->m_CPUs.size(); ++idx)
+      addCPU((*thread)->m_CPUs[idx]);
+    addRunningRatio((*thread)->m_RunningRatio);
+    m_Profile.merge((*thread)->m_Profile);
+  }
+
+  // the k-th samples of all threads are taken at about the same time
+  std::vector<double> events(m_PerfEvents.size());
+  for (size_t k = 0; k < samples; ++k) {
+    double time = 0.0;
+    std::fill(events.begin(), events.end(), 0.0);
+    for (thread = pThreads.begin(); thread != tEnd; ++thread) {
+      time += (*thread)->m_TimerSamples[k] / m_NumOfThreads;
+      for (unsigned int idx = 0; idx < events.size(); ++idx) {
+        events[idx] += (*thread)->m_PerfEvents[idx].samples[k] /
+                       m_NumOfThreads;
+      }
+    }
+    addSample(time, events);
+  }
+  summarize();
 }
 
 //===----------------------------------------------------------------------===//
@@ -279,6 +1262,8 @@ void testing::TestInfo::run()
   Repeater& repeater = unittest.repeater();
   skypat::Test* test = m_pFactory->CreateTest();
   if (NULL != test) {
+    test->m_Args = m_Args;
+
     repeater.OnSetUpStart(unittest);
     test->SetUp();
     repeater.OnSetUpEnd(unittest);
@@ -306,6 +1291,37 @@ void testing::TestInfo::addTestPartResult(const TestPartResult& pResult)
   }
 }
 
+std::string testing::TestInfo::getKey(const PerfPartResult& pResult) const
+{
+  return getCaseName() + "." + getTestName() + "." + getRegion(pResult);
+}
+
+std::string testing::TestInfo::getRegion(const PerfPartResult& pResult) const
+{
+  std::string result;
+  if (NULL != pResult.getParent())
+    result = getRegion(*pResult.getParent()) + "/";
+  result += Label(pResult);
+
+  OStrStream OS(result);
+  unsigned int occurrence = 1;
+  PerfPartResultList::const_iterator perf, pEnd = m_PerfResultList.end();
+  for (perf = m_PerfResultList.begin(); perf != pEnd; ++perf) {
+    if (&pResult == *perf)
+      break;
+    if (IsSameRegion(pResult, **perf))
+      ++occurrence;
+  }
+  if (1 < occurrence)
+    OS << "~" << occurrence;
+
+  if (!pResult.getThreadResults().empty() || -1 != pResult.getThreadIndex())
+    OS << "@" << pResult.getNumOfThreads();
+  if (-1 != pResult.getThreadIndex())
+    OS << "#" << pResult.getThreadIndex();
+  return result;
+}
+
 testing::PerfPartResult*
 testing::TestInfo::addPerfPartResult(const char* pFile, int pLine)
 {